@@ -0,0 +1,65 @@
+#!/bin/sh
+#####################################################################
+# check the memory budget of compcoll (-M), run by "make check"
+#
+# The estimator and the fallback are inside compcoll, so they are checked
+# from the outside: the algorithm it picks, and the HTML it outputs.
+#
+# Copyright 2014 Yunhui Fu
+# License: GPL v3.0 or later
+#####################################################################
+
+SRCDIR="${srcdir:-.}"
+EXEC_COMPCOLL="./compcoll"
+FILE_A="${SRCDIR}/../test/001a.txt"
+FILE_B="${SRCDIR}/../test/001b.txt"
+DN_TMP=$(mktemp -d "${TMPDIR:-/tmp}/compcoll-check-XXXXXX") || exit 1
+trap 'rm -rf "${DN_TMP}"' EXIT
+
+FAILED=0
+
+fail () {
+    echo "FAIL: $1"
+    FAILED=1
+}
+
+# run compcoll with the options in $1 on the files $2 and $3, the output to $4.html and $4.log
+run_compcoll () {
+    ${EXEC_COMPCOLL} $1 "$2" "$3" > "${DN_TMP}/$4.html" 2> "${DN_TMP}/$4.log"
+}
+
+# the budget is a number with the suffix K, M or G; anything else is rejected
+for SIZE in 12X -1 M 1.5G 99999999999999999999G; do
+    if run_compcoll "-M ${SIZE}" "${FILE_A}" "${FILE_B}" bad; then
+        fail "-M ${SIZE} is accepted"
+    fi
+done
+
+run_compcoll "" "${FILE_A}" "${FILE_B}" full || fail "full"
+run_compcoll "-a linear" "${FILE_A}" "${FILE_B}" linear || fail "linear"
+
+# within the budget: the algorithm is kept
+run_compcoll "-M 1G" "${FILE_A}" "${FILE_B}" big || fail "-M 1G"
+grep -q "within the budget" "${DN_TMP}/big.log" || fail "-M 1G does not keep full"
+cmp -s "${DN_TMP}/full.html" "${DN_TMP}/big.html" || fail "-M 1G changes the output"
+
+# the full matrix is over it and the checkpoint rows fit: the same path as full
+run_compcoll "-M 16M" "${FILE_A}" "${FILE_B}" ckpt || fail "-M 16M"
+grep -q "use checkpoint" "${DN_TMP}/ckpt.log" || fail "-M 16M does not fall back to checkpoint"
+cmp -s "${DN_TMP}/full.html" "${DN_TMP}/ckpt.html" || fail "-M 16M changes the output"
+
+# nothing fits: the linear one
+run_compcoll "-M 64K" "${FILE_A}" "${FILE_B}" tiny || fail "-M 64K"
+grep -q "use linear" "${DN_TMP}/tiny.log" || fail "-M 64K does not fall back to linear"
+cmp -s "${DN_TMP}/linear.html" "${DN_TMP}/tiny.html" || fail "-M 64K is not the output of linear"
+
+# the long common prefix and suffix are not in the DP, so they don't count in the estimate
+awk 'BEGIN { srand (3); for (i = 0; i < 30000; i ++) { s = s sprintf ("%c", 97 + int (rand () * 8)); } print s "xyz middle one" s; }' > "${DN_TMP}/trima.txt"
+awk 'BEGIN { srand (3); for (i = 0; i < 30000; i ++) { s = s sprintf ("%c", 97 + int (rand () * 8)); } print s "qq middle two!" s; }' > "${DN_TMP}/trimb.txt"
+run_compcoll "-M 1M" "${DN_TMP}/trima.txt" "${DN_TMP}/trimb.txt" trim || fail "-M 1M of the trimmed pair"
+grep -q "within the budget" "${DN_TMP}/trim.log" || fail "-M 1M counts the common prefix and suffix"
+
+if [ "${FAILED}" = "0" ]; then
+    echo "PASS: memory budget"
+fi
+exit ${FAILED}
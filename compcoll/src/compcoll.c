@@ -15,6 +15,8 @@
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <limits.h>    /* PATH_MAX */
 #include <getopt.h>
 
 #include <inttypes.h> /* for PRIdPTR PRIiPTR PRIoPTR PRIuPTR PRIxPTR PRIXPTR, SCNdPTR SCNiPTR SCNoPTR SCNuPTR SCNxPTR */
@@ -34,6 +36,8 @@
 #include "utf8utils.h"
 #include "editdistance.h"
 #include "mymat.h"
+#include "edmatrix.h"
+#include "ednuma.h"
 
 #if _WIN32
 #define tmpfile64() tmpfile()
@@ -68,6 +72,32 @@ help (char *progname)
     fprintf (stderr, "\t-m\tmerge the same changes\n");
     fprintf (stderr, "\t-r\toutput <return>, all|old|new\n");
     fprintf (stderr, "\t-x\tset the sequence # of the title\n");
+    fprintf (stderr, "\t-d\toutput the edit distance only(no HTML)\n");
+    fprintf (stderr, "\t-a\tthe algorithm to find the path, full|linear|linear-mt|myers|banded|simd|tiled|lv|bitpar|4r|checkpoint|recursive\n");
+    fprintf (stderr, "\t\t  full   - the full matrix, 2 bits per cell (default)\n");
+    fprintf (stderr, "\t\t  linear - Hirschberg, O(m+n) memory, about twice of the time\n");
+    fprintf (stderr, "\t\t  linear-mt - Hirschberg in multiple threads(-j), the same path as linear\n");
+    fprintf (stderr, "\t\t  myers  - Myers O(ND) diff, insert/delete only, fast for similar texts\n");
+    fprintf (stderr, "\t\t  banded - the band around the diagonal, O((m+n)*D) memory\n");
+    fprintf (stderr, "\t\t  simd   - the full matrix by anti-diagonals with SSE4.1/AVX2, 1 byte per cell\n");
+    fprintf (stderr, "\t\t  tiled  - the full matrix by tiles in multiple threads(-j), 1 byte per cell\n");
+    fprintf (stderr, "\t\t  lv     - Landau-Vishkin with the suffix array, O((m+n)*log(m+n) + D^2) time, fast for similar texts,\n");
+    fprintf (stderr, "\t\t           O(D^2) memory plus the suffix array, so the texts with many differences run out of memory\n");
+    fprintf (stderr, "\t\t  bitpar - the bit-parallel matrix, 2 bits per cell and an int per 64 cells, about 2.5 bits per cell (1/13 of an int)\n");
+    fprintf (stderr, "\t\t  4r     - a blocked kernel of the Four Russians table, 3x3 cells per lookup, 4 bytes per 9 cells,\n");
+    fprintf (stderr, "\t\t           a constant-factor speedup only, still O(m*n) time since the block size is fixed\n");
+    fprintf (stderr, "\t\t  checkpoint - the values of every k-th row(-i), about twice of the time, O(m*sqrt(n)) memory\n");
+    fprintf (stderr, "\t\t  recursive - the full matrix stored by tiles, filled by the recursive halving, for the very long lines\n");
+    fprintf (stderr, "\t-i\tthe interval of the checkpoint rows for '-a checkpoint', less memory and more time if smaller, 0 -- sqrt(rows)(default)\n");
+    fprintf (stderr, "\t-j\tthe number of threads, default is the number of CPUs\n");
+    fprintf (stderr, "\t-k\tthe length of the anchors, the unique strings in both files, to split the DP, 0 -- no anchor(default)\n");
+    fprintf (stderr, "\t-t\tthe threshold of the difference in percent, the files are not aligned if at least so many characters differ\n");
+    fprintf (stderr, "\t\t  (estimated by the q-grams before the DP), 0 -- always align(default)\n");
+    fprintf (stderr, "\t-w\tthe directory of the scratch files, the directions of the DP are stored in the files for the lines too long for the memory\n");
+    fprintf (stderr, "\t\t  (full, recursive and checkpoint only, the values stay in the memory by the deltas in about 0.3 byte per cell)\n");
+    fprintf (stderr, "\t-M\tthe memory budget of the alignment, such as 512M or 2G, the algorithm falls back to\n");
+    fprintf (stderr, "\t\t  checkpoint, then linear, if its estimated memory is over it, 0 -- no limit(default)\n");
+    fprintf (stderr, "\t-N\treport the NUMA nodes, the CPUs of the pinned threads(-a tiled|linear-mt) and the nodes of the matrices\n");
     fprintf (stderr, "\t-h\tPrint this message.\n");
     fprintf (stderr, "\t-v\tVerbose information.\n");
 }
@@ -389,6 +419,246 @@ wpair_output_ret (wcstrpair_t *wp)
     fprintf (stdout, "<br />");
 }
 
+// the algorithm used to get the edit path
+#define ALGO_FULL   0 /* ed_edit_distance_path_fast() */
+#define ALGO_LINEAR 1 /* ed_edit_distance_path_linear() */
+#define ALGO_MYERS  2 /* ed_edit_distance_path_myers() */
+#define ALGO_BANDED 3 /* ed_edit_distance_path_banded() */
+#define ALGO_SIMD   4 /* ed_edit_distance_path_simd() */
+#define ALGO_TILED  5 /* ed_edit_distance_path_tiled() */
+#define ALGO_LV     6 /* ed_edit_distance_path_lv() */
+#define ALGO_BITPAR 7 /* ed_edit_distance_path_bitpar() */
+#define ALGO_4R     8 /* ed_edit_distance_path_4r() */
+#define ALGO_CKPT   9 /* ed_edit_distance_path_checkpoint() */
+#define ALGO_RECURSIVE 10 /* ed_edit_distance_path_recursive() */
+#define ALGO_LINEAR_MT 11 /* ed_edit_distance_path_linear_mt() */
+
+char flg_algo = ALGO_FULL;
+int num_threads = 0; /* the number of threads, 0 -- the number of CPUs */
+size_t checkpoint_interval = 0; /* the interval of the checkpoint rows, 0 -- sqrt(rows) */
+size_t anchor_len = 0; /* the length of the k-gram anchors, 0 -- no anchor */
+int max_diff_percent = 0; /* the threshold of the difference in percent, 0 -- always align */
+char *scratch_dir = NULL; /* the directory of the scratch files of the DP matrices, NULL -- in memory */
+size_t max_mem = 0; /* the memory budget of the alignment of a pair in bytes, 0 -- no limit */
+char flg_numa = 0; /* report the NUMA placement of the threads and the matrices */
+
+static char algo_pair = ALGO_FULL; /* the algorithm of the current pair, flg_algo or the fallback for max_mem */
+
+/* the names of ALGO_*, the values of '-a' */
+static const char *algo_names[] = {
+    "full", "linear", "myers", "banded", "simd", "tiled", "lv", "bitpar", "4r", "checkpoint", "recursive", "linear-mt",
+};
+
+#define QGRAM_LEN 2 /* the length of the q-grams to estimate the difference */
+
+/* if the lower bound of the distance by the q-grams reaches the threshold, return the bound; otherwise return -1 */
+static int
+compcoll_too_different (strcmp_t *cmpinfo, size_t maxlen)
+{
+    int lower;
+
+    if (max_diff_percent <= 0) {
+        return -1;
+    }
+    lower = ed_qgram_lower_bound (cmpinfo, QGRAM_LEN);
+    if ((lower > 0) && ((size_t)lower * 100 >= maxlen * max_diff_percent)) {
+        return lower;
+    }
+    return -1;
+}
+
+/**
+ * @brief estimate the memory used by the algorithm to align two strings, before any allocation
+ *
+ * @param algo : ALGO_*
+ * @param lena : the length of the `left' string
+ * @param lenb : the length of the `right' string
+ *
+ * @return the bytes, include the copies of the strings and the path
+ *
+ * The matrices follow the allocations of each algorithm. The ones depend on the distance D
+ * (banded, lv) are estimated with the largest D, since D is unknown before the alignment.
+ */
+static size_t
+compcoll_estimate_mem (char algo, size_t lena, size_t lenb)
+{
+    size_t cols = lena + 1;
+    size_t rows = lenb + 1;
+    size_t maxd = lena + lenb;
+    size_t k;
+    size_t nthreads;
+    /* the strings fetched by ed_fetch_string() and the path */
+    size_t ret = (lena + lenb) * (sizeof (wchar_t) + sizeof (char));
+    /* the values by the deltas in the memory with -w, see generate_compare_file() */
+    size_t szdelta = rows * ((cols + MYMAT_DELTA_MASK) >> MYMAT_DELTA_BITS) * MYMAT_DELTA_ITEM;
+
+    switch (algo) {
+    case ALGO_LINEAR:
+        return ret + sizeof (int) * cols * 4;
+    case ALGO_LINEAR_MT:
+        nthreads = (num_threads > 0)?num_threads:sysconf (_SC_NPROCESSORS_ONLN);
+        return ret + sizeof (int) * cols * 4 * ((nthreads > 0)?nthreads:1);
+    case ALGO_MYERS:
+        return ret + sizeof (int) * (maxd + 2) * 2;
+    case ALGO_BANDED:
+        /* the directions of the band in bytes */
+        return ret + rows * (maxd + 1) + sizeof (int) * (maxd + 1) * 2;
+    case ALGO_SIMD:
+    case ALGO_TILED:
+        /* 1 byte per cell */
+        return ret + rows * cols + sizeof (int) * (lena + lenb) * 3;
+    case ALGO_LV:
+        /* the sparse table of the LCE and the furthest points of each (e, k) */
+        for (k = 1; ((size_t)1 << k) <= maxd + 1; k ++);
+        return ret + sizeof (int) * (maxd + 1) * (4 + k) + sizeof (int) * (maxd + 1) * (maxd + 1);
+    case ALGO_BITPAR:
+        /* 2 words per 64 cells, and the value at the bottom of each block */
+        return ret + ((lenb + 63) / 64) * cols * (sizeof (uint64_t) * 2 + sizeof (int));
+    case ALGO_4R:
+        return ret + rows * cols * 4 / 9;
+    case ALGO_CKPT:
+        k = checkpoint_interval;
+        if (k < 1) {
+            for (k = 1; k * k < lenb; k ++);
+        }
+        if (k > lenb) {
+            k = (lenb > 0)?lenb:1;
+        }
+        /* the rows between two checkpoints, and the checkpoint rows of the narrowest integers */
+        return ret + sizeof (int) * (k + 1) * cols + (lenb / k + 1) * cols * ((maxd > INT16_MAX)?4:((maxd > INT8_MAX)?2:1));
+    case ALGO_RECURSIVE:
+        /* the values of the narrowest integers and the directions in 2 bits, by the tiles */
+        rows = (rows + MYMAT_TILE_MASK) & ~((size_t)MYMAT_TILE_MASK);
+        cols = (cols + MYMAT_TILE_MASK) & ~((size_t)MYMAT_TILE_MASK);
+        if (NULL != scratch_dir) {
+            return ret + szdelta;
+        }
+        return ret + rows * cols * ((maxd > INT16_MAX)?4:((maxd > INT8_MAX)?2:1)) + rows * cols / 4;
+    }
+    if (NULL != scratch_dir) {
+        /* the directions are in the scratch file */
+        return ret + szdelta;
+    }
+    /* ALGO_FULL: two rows of the values, and the directions in 2 bits */
+    return ret + sizeof (int) * cols * 2 + rows * ((cols + 31) / 32) * sizeof (uint64_t);
+}
+
+/**
+ * @brief pick the algorithm for the pair within max_mem
+ *
+ * @param lena : the length of the `left' string
+ * @param lenb : the length of the `right' string
+ *
+ * @return flg_algo if it fits, otherwise the checkpoint, which gets the same path as the full matrix,
+ *   or the linear one at last
+ */
+static char
+compcoll_fit_budget (size_t lena, size_t lenb)
+{
+    size_t need;
+    char algo = flg_algo;
+
+    if (max_mem < 1) {
+        return flg_algo;
+    }
+    need = compcoll_estimate_mem (algo, lena, lenb);
+    if (need <= max_mem) {
+        fprintf (stderr, "memory: %s needs about %zu KiB, within the budget of %zu KiB\n", algo_names[(int)algo], need >> 10, max_mem >> 10);
+        return algo;
+    }
+    if ((ALGO_LINEAR != algo) && (ALGO_LINEAR_MT != algo) && (ALGO_CKPT != algo)
+        && (compcoll_estimate_mem (ALGO_CKPT, lena, lenb) <= max_mem)) {
+        algo = ALGO_CKPT;
+    } else {
+        /* the least memory, used even if it's still over the budget */
+        algo = ALGO_LINEAR;
+    }
+    fprintf (stderr, "memory: %s needs about %zu KiB, over the budget of %zu KiB, use %s (about %zu KiB)\n",
+        algo_names[(int)flg_algo], need >> 10, max_mem >> 10, algo_names[(int)algo], compcoll_estimate_mem (algo, lena, lenb) >> 10);
+    return algo;
+}
+
+/**
+ * @brief parse the size such as "512M", the suffix K, M and G are the units of 1024
+ *
+ * @param str : the string of the size
+ * @param ret_size : the bytes
+ *
+ * @return 0 on success, -1 if it's not a number, the suffix is unknown, or it overflows
+ */
+static int
+compcoll_parse_size (const char *str, size_t *ret_size)
+{
+    char *end = NULL;
+    unsigned long long val;
+    int shift = 0;
+
+    /* strtoull() takes a sign, and "-1" would wrap to the largest value */
+    if ((*str < '0') || (*str > '9')) {
+        return -1;
+    }
+    errno = 0;
+    val = strtoull (str, &end, 10);
+    if (0 != errno) {
+        return -1;
+    }
+    switch (*end) {
+    case 'G':
+    case 'g':
+        shift += 10;
+        /* fall through */
+    case 'M':
+    case 'm':
+        shift += 10;
+        /* fall through */
+    case 'K':
+    case 'k':
+        shift += 10;
+        end ++;
+        break;
+    }
+    if (('\0' != *end) || (val > (SIZE_MAX >> shift))) {
+        return -1;
+    }
+    *ret_size = (size_t)val << shift;
+    return 0;
+}
+
+/* get the edit path by the algorithm algo_pair */
+static int
+compcoll_edit_path (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    switch (algo_pair) {
+    case ALGO_LINEAR:
+        return ed_edit_distance_path_linear (cmpinfo, path, ret_numpath);
+    case ALGO_LINEAR_MT:
+        return ed_edit_distance_path_linear_mt (cmpinfo, num_threads, path, ret_numpath);
+    case ALGO_MYERS:
+        return ed_edit_distance_path_myers (cmpinfo, path, ret_numpath);
+    case ALGO_BANDED:
+        return ed_edit_distance_path_banded (cmpinfo, path, ret_numpath);
+    case ALGO_SIMD:
+        return ed_edit_distance_path_simd (cmpinfo, EDSIMD_AUTO, path, ret_numpath);
+    case ALGO_TILED:
+        return ed_edit_distance_path_tiled (cmpinfo, num_threads, path, ret_numpath);
+    case ALGO_LV:
+        return ed_edit_distance_path_lv (cmpinfo, path, ret_numpath);
+    case ALGO_BITPAR:
+        return ed_edit_distance_path_bitpar (cmpinfo, path, ret_numpath);
+    case ALGO_4R:
+        return ed_edit_distance_path_4r (cmpinfo, path, ret_numpath);
+    case ALGO_CKPT:
+        return ed_edit_distance_path_checkpoint (cmpinfo, checkpoint_interval, path, ret_numpath);
+    case ALGO_RECURSIVE:
+        return ed_edit_distance_path_recursive (cmpinfo, path, ret_numpath);
+    }
+    if (NULL != scratch_dir) {
+        /* the same path, with the matrices in the scratch files */
+        return ed_edit_distance_path (cmpinfo, path, ret_numpath);
+    }
+    return ed_edit_distance_path_fast (cmpinfo, path, ret_numpath);
+}
+
 void
 generate_compare_file(wcstrpair_t *wp)
 {
@@ -397,8 +667,40 @@ generate_compare_file(wcstrpair_t *wp)
 
     mymatrix_t mat1;
     mymatrix_t mat2;
-    mymat_init (&mat1);
-    mymat_init (&mat2);
+    void *edm1 = NULL;
+    void *edm2 = NULL;
+
+    /* the common prefix and suffix are not changed, only the middle goes to the DP */
+    size_t szprefix = ed_common_prefix (wp->str[0], wp->str[1], (wp->len[0] < wp->len[1])?wp->len[0]:wp->len[1]);
+    size_t szsuffix = 0;
+    wcstrpair_t wpmid;
+    strcmp_t cmpmid;
+    szsuffix = ed_common_suffix (wp->str[0] + szprefix, wp->len[0] - szprefix, wp->str[1] + szprefix, wp->len[1] - szprefix);
+    wpmid = *wp;
+    for (i = 0; i < 2; i ++) {
+        wpmid.str[i] += szprefix;
+        wpmid.len[i] -= szprefix + szsuffix;
+    }
+    /* the matrices are only for the middle */
+    algo_pair = compcoll_fit_budget (wpmid.len[0], wpmid.len[1]);
+
+    /* the values by the deltas in 2.5 bits per cell, the directions in 1 byte */
+    mymat_init_delta (&mat1);
+    mymat_init_compact (&mat2);
+    /* each element is written by the fill before it's read */
+    mymat_set_nozero (&mat1, 1);
+    mymat_set_nozero (&mat2, 1);
+    if (ALGO_RECURSIVE == algo_pair) {
+        /* the recursive fill visits the matrix by blocks */
+        mymat_set_tiled (&mat1, 1);
+        mymat_set_tiled (&mat2, 1);
+    }
+    if (NULL != scratch_dir) {
+        /* only the directions, the values by the deltas stay in the memory;
+         * by the tiles, the traceback reads the file band by band */
+        mymat_set_file (&mat2, scratch_dir);
+        mymat_set_tiled (&mat2, 1);
+    }
 
     strcmp_t cmpinfo;
     cmpinfo.userdata_str = wp;
@@ -419,16 +721,72 @@ generate_compare_file(wcstrpair_t *wp)
         perror ("malloc");
         return;
     }
+    if ((NULL == scratch_dir) && ((ALGO_RECURSIVE == algo_pair) || (ALGO_CKPT == algo_pair))) {
+        /* the narrowest elements: the values are in [0, max length], the directions in 2 bits */
+        int layout = ((ALGO_RECURSIVE == algo_pair)?EDMAT_TILED:EDMAT_ROWS);
+        size_t maxlen = (wpmid.len[0] > wpmid.len[1])?wpmid.len[0]:wpmid.len[1];
+        edm1 = edmat_create (edmat_type_fit (0, maxlen), layout);
+        edm2 = edmat_create (EDMAT_BIT2, layout);
+        if ((NULL == edm1) || (NULL == edm2)) {
+            fprintf (stderr, "Error in creating the matrices\n");
+            edmat_destroy (edm1);
+            edmat_destroy (edm2);
+            free (path);
+            return;
+        }
+        cmpinfo.userdata_matrix  = edm1;
+        cmpinfo.userdata_matrix2 = edm2;
+        cmpinfo.cb_matget  = edmat_get;
+        cmpinfo.cb_matset  = edmat_set;
+        cmpinfo.cb_matresz = edmat_resize;
+    }
 
 #if USE_OUT_ED_TABLE
     ret = ed_edit_distance (&cmpinfo);
     fprintf (stderr, "different sites 1 = %d\n", ret);
 #endif
-    ret = ed_edit_distance_path (&cmpinfo, path, &szpath);
+    cmpmid = cmpinfo;
+    cmpmid.userdata_str = &wpmid;
+    if ((wpmid.len[0] > 0) || (wpmid.len[1] > 0)) {
+        ret = compcoll_too_different (&cmpmid, (wp->len[0] > wp->len[1])?wp->len[0]:wp->len[1]);
+        if (ret >= 0) {
+            fprintf (stderr, "different sites >= %d, too different, not aligned\n", ret);
+            printf ("<p><b>Too different, not aligned:</b> at least %d different sites.</p>\n", ret);
+            mymat_clear (&mat1);
+            mymat_clear (&mat2);
+            edmat_destroy (edm1);
+            edmat_destroy (edm2);
+            free (path);
+            return;
+        }
+    }
+    /* the DP only runs between the anchors if anchor_len > 0; the suffix is only set if it succeeds */
+    ret = ed_edit_distance_path_trim (&cmpmid, szprefix, szsuffix, anchor_len, compcoll_edit_path, path, &szpath);
     fprintf (stderr, "different sites = %d\n", ret);
+    if (flg_numa) {
+        /* the matrices given by the cb_mat*, if the algorithm used them; the other buffers are accounted by the algorithms */
+        if (NULL != edm1) {
+            size_t szmat = 0;
+            const void *buf = edmat_buffer (edm1, &szmat);
+            ed_numa_account ("matrix of values", buf, szmat);
+            buf = edmat_buffer (edm2, &szmat);
+            ed_numa_account ("matrix of directions", buf, szmat);
+        } else {
+            ed_numa_account ("matrix of values", mat1.buf, mat1.szitem * mat1.szbuf);
+            ed_numa_account ("matrix of directions", mat2.buf, mat2.szitem * mat2.szbuf);
+        }
+        ed_numa_report (stderr);
+    }
 
     mymat_clear (&mat1);
     mymat_clear (&mat2);
+    edmat_destroy (edm1);
+    edmat_destroy (edm2);
+    if (ret < 0) {
+        fprintf (stderr, "Error in getting the edit path\n");
+        free (path);
+        return;
+    }
 
     int x = 0; // index of string 1
     int y = 0; // index of string 2
@@ -483,6 +841,23 @@ generate_compare_file(wcstrpair_t *wp)
     free (path);
 }
 
+// only calculate the edit distance of the two files, -1 if they are too different
+int
+calculate_distance (wcstrpair_t *wp)
+{
+    strcmp_t cmpinfo;
+    memset (&cmpinfo, 0, sizeof (cmpinfo));
+    cmpinfo.userdata_str = wp;
+    cmpinfo.cb_comp = strcmp_comp_utf8fp;
+    cmpinfo.cb_len  = strcmp_length_utf8fp;
+    cmpinfo.cb_getval = strcmp_cb_getval_utf8fp;
+    cmpinfo.cb_output = strcmp_output_utf8fp;
+    if (compcoll_too_different (&cmpinfo, (wp->len[0] > wp->len[1])?wp->len[0]:wp->len[1]) >= 0) {
+        return -1;
+    }
+    return ed_edit_distance_bitpar (&cmpinfo);
+}
+
 #define HTML_OUT_HEADER \
     "<!DOCTYPE html>" "\n" \
     "<html>" "\n" \
@@ -517,7 +892,38 @@ generate_compare_file(wcstrpair_t *wp)
     "</html>"
 
 char flg_nohtmlhdr = 0;
+char flg_distonly = 0;
+
+/**
+ * @brief check the directory of -w before any alignment, exit if no scratch file can be created in it
+ *
+ * @param progname : the name of the program
+ *
+ * Only full, recursive and checkpoint store their matrices by the mymatrix_t, the other algorithms ignore -w.
+ */
+static void
+compcoll_check_scratch (const char *progname)
+{
+    char fname[PATH_MAX];
+    int fd;
 
+    if (NULL == scratch_dir) {
+        return;
+    }
+    snprintf (fname, sizeof (fname), "%s/compcoll-XXXXXX", scratch_dir);
+    fd = mkstemp (fname);
+    if (fd < 0) {
+        fprintf (stderr, "%s: Can't create the scratch file in '%s': %s\n", progname, scratch_dir, strerror (errno));
+        exit (-1);
+    }
+    close (fd);
+    unlink (fname);
+    if (flg_distonly) {
+        fprintf (stderr, "%s: Warning: -w has no effect with -d, no matrix is stored\n", progname);
+    } else if ((ALGO_FULL != flg_algo) && (ALGO_RECURSIVE != flg_algo) && (ALGO_CKPT != flg_algo)) {
+        fprintf (stderr, "%s: Warning: -w has no effect with '-a %s', its matrices are in the memory\n", progname, algo_names[(int)flg_algo]);
+    }
+}
 
 // flg_merge: 1  - merge the same <del>/<ins>
 int
@@ -546,6 +952,12 @@ compare_files (ssize_t idx, char * filename1, char *filename2, char flg_merge, c
     load_file (&wpinfo, 0, fp1);
     load_file (&wpinfo, 1, fp2);
 
+    if (flg_distonly) {
+        printf ("%d\t%s\t%s\n", calculate_distance (&wpinfo), filename1, filename2);
+        wcspair_clear (&wpinfo);
+        goto end_compfile;
+    }
+
     if (! flg_nohtmlhdr) {
         printf ("%s\n", HTML_OUT_HEADER);
     }
@@ -585,13 +997,22 @@ main (int argc, char * argv[])
         { "mergechanges", 0, 0, 'm' },
         { "outreturn",    1, 0, 'r' },
         { "indexnum",     1, 0, 'x' },
+        { "algorithm",    1, 0, 'a' },
+        { "distance",     0, 0, 'd' },
+        { "threads",      1, 0, 'j' },
+        { "interval",     1, 0, 'i' },
+        { "anchor",       1, 0, 'k' },
+        { "threshold",    1, 0, 't' },
+        { "scratch",      1, 0, 'w' },
+        { "max-mem",      1, 0, 'M' },
+        { "numa",         0, 0, 'N' },
 
         { "help",         0, 0, 'h' },
         { "verbose",      0, 0, 'v' },
         { 0,              0, 0,  0  },
     };
 
-    while ((c = getopt_long( argc, argv, "mr:x:HTCvh", longopts, NULL )) != EOF) {
+    while ((c = getopt_long( argc, argv, "mr:x:a:di:j:k:t:w:M:NHTCvh", longopts, NULL )) != EOF) {
         switch (c) {
         case 'H':
             printf ("%s\n", HTML_OUT_HEADER);
@@ -604,6 +1025,35 @@ main (int argc, char * argv[])
         case 'C':
             flg_nohtmlhdr = 1;
             break;
+        case 'd':
+            flg_distonly = 1;
+            break;
+        case 'i':
+            checkpoint_interval = atoi(optarg);
+            break;
+        case 'j':
+            num_threads = atoi(optarg);
+            break;
+        case 'k':
+            anchor_len = atoi(optarg);
+            break;
+        case 't':
+            max_diff_percent = atoi(optarg);
+            break;
+        case 'w':
+            scratch_dir = optarg;
+            break;
+        case 'M':
+            if (compcoll_parse_size (optarg, &max_mem) < 0) {
+                fprintf (stderr, "%s: Invalid memory budget: '%s', use the bytes, or a number with K, M or G.\n", argv[0], optarg);
+                fprintf (stderr, "Use '%s -h' for more information.\n", basename(argv[0]));
+                exit (-1);
+            }
+            break;
+        case 'N':
+            flg_numa = 1;
+            ed_numa_set_report (1);
+            break;
         case 'r':
             if (0 == strcmp(optarg, "all")) {
                 flg_outret = OUT_RET_NEW | OUT_RET_OLD;
@@ -619,6 +1069,36 @@ main (int argc, char * argv[])
         case 'x':
             idx = atoi(optarg);
             break;
+        case 'a':
+            if (0 == strcmp(optarg, "full")) {
+                flg_algo = ALGO_FULL;
+            } else if (0 == strcmp(optarg, "linear")) {
+                flg_algo = ALGO_LINEAR;
+            } else if (0 == strcmp(optarg, "linear-mt")) {
+                flg_algo = ALGO_LINEAR_MT;
+            } else if (0 == strcmp(optarg, "myers")) {
+                flg_algo = ALGO_MYERS;
+            } else if (0 == strcmp(optarg, "banded")) {
+                flg_algo = ALGO_BANDED;
+            } else if (0 == strcmp(optarg, "simd")) {
+                flg_algo = ALGO_SIMD;
+            } else if (0 == strcmp(optarg, "tiled")) {
+                flg_algo = ALGO_TILED;
+            } else if (0 == strcmp(optarg, "lv")) {
+                flg_algo = ALGO_LV;
+            } else if (0 == strcmp(optarg, "bitpar")) {
+                flg_algo = ALGO_BITPAR;
+            } else if (0 == strcmp(optarg, "4r")) {
+                flg_algo = ALGO_4R;
+            } else if (0 == strcmp(optarg, "checkpoint")) {
+                flg_algo = ALGO_CKPT;
+            } else if (0 == strcmp(optarg, "recursive")) {
+                flg_algo = ALGO_RECURSIVE;
+            } else {
+                fprintf (stderr, "%s: Unknown algorithm: '%s'.\n", argv[0], optarg);
+                exit (-1);
+            }
+            break;
 
         case 'v':
             break;
@@ -635,6 +1115,8 @@ main (int argc, char * argv[])
         }
     }
 
+    compcoll_check_scratch (argv[0]);
+
     //test1(); return 0;
 
     c = optind;
@@ -0,0 +1,431 @@
+/**
+ * @file    ed4russians.c
+ * @brief   Edit distance by a constant-factor blocked kernel: the Four Russians table lookup (W. Masek, M. Paterson 1980)
+ *          with the block size fixed at t = 3, so the time is still O(m*n), not O(m*n/log(n))
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#include <sys/types.h> /* ssize_t */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "editdistance.h"
+#include "ednuma.h"
+
+#define ED4R_T     3    /* the rows and columns of a block */
+#define ED4R_NDELTA 27  /* 3^ED4R_T, the number of the delta vectors of a block side */
+#define ED4R_NEQ   512  /* 2^(ED4R_T*ED4R_T), the number of the equal masks of a block */
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+
+/**
+ * 矩阵分成 t x t 的块。块内的值只依赖于:
+ *   块顶部的横向差值向量 top(每个 -1/0/+1, 按三进制编码为 0..26),
+ *   块左边的纵向差值向量 left(同上),
+ *   块内 t x t 个字符是否相等的位图 eq(第 c 列第 r 行为 bit c*t+r)。
+ * 所以底部的横向差值和右边的纵向差值可以预先对所有 27 x 27 x 512 种组合算好，查表一次就算完一个块。
+ * 字符先按 b 中出现的字符压缩成类别号，每个块行(t 行)内字符类别到 t 位掩码的表只有 t 项不为 0，
+ * 这样每列的相等掩码只需要查一次表，汉字字符集大也不影响。
+ *
+ * 不满 t 行或 t 列的边缘块直接计算。回溯时只保存每个块的表索引(4字节)，用到时重新计算块内的值。
+ *
+ * 论文中 t 取 log(n) 的量级, 时间为 O(m*n/log(n))。这里故意固定 t = 3, 不随 n 变化:
+ * 表有 3^t x 3^t x 2^(t*t) 项, t = 3 时为 373248 项(729 KiB), t = 4 时已是 4.3 亿项(820 MiB),
+ * t = log3(n)/2 在 n >= 3^8 = 6561 时就到了 4, 所以按 log(n) 再加上表的内存上限算出的 t 对常见的 n 总是 3,
+ * 只有 n < 729 时会取 2, 那时一次建表的时间本来就可以忽略。
+ * 因此这里只是常数倍(约 t 倍)的加速, 时间仍为 O(m*n)。
+ */
+
+/* the output of a block: the deltas of the bottom and the right side */
+typedef struct _ed4r_out_t {
+    uint8_t bottom;
+    uint8_t right;
+} ed4r_out_t;
+
+static ed4r_out_t * g_ed4r_table = NULL;
+static pthread_once_t g_ed4r_once = PTHREAD_ONCE_INIT;
+
+#define ED4R_KEY(top,left,eq) ((((uint32_t)(top) * ED4R_NDELTA) + (left)) * ED4R_NEQ + (eq))
+#define ED4R_KEY_TOP(key)  ((key) / ED4R_NEQ / ED4R_NDELTA)
+#define ED4R_KEY_LEFT(key) (((key) / ED4R_NEQ) % ED4R_NDELTA)
+#define ED4R_KEY_EQ(key)   ((key) % ED4R_NEQ)
+
+/* 3^w, the delta vector of w +1 is 3^w - 1 */
+static const int g_ed4r_pow3[ED4R_T + 1] = {1, 3, 9, 27};
+
+/* the sum of the deltas in a vector */
+static int g_ed4r_sum[ED4R_NDELTA];
+
+/**
+ * @brief 计算一个块内所有的值, 以左上角为 0
+ *
+ * @param top, left, eq : 块的输入
+ * @param w, h : 块的列数和行数, <= ED4R_T
+ * @param val : 输出 (h + 1) x (w + 1) 个值, 每行 ED4R_T + 1 个
+ * @param ret : 若不为 NULL, 输出底部和右边的差值
+ */
+static void
+ed4r_block (int top, int left, int eq, int w, int h, int *val, ed4r_out_t *ret)
+{
+    int r;
+    int c;
+    int pi;
+    int pd;
+    int pr;
+    int pw;
+
+#define ED4R_VAL(r,c) val[(r) * (ED4R_T + 1) + (c)]
+    ED4R_VAL(0, 0) = 0;
+    for (c = 0; c < w; c ++, top /= 3) {
+        ED4R_VAL(0, c + 1) = ED4R_VAL(0, c) + (top % 3) - 1;
+    }
+    for (r = 0; r < h; r ++, left /= 3) {
+        ED4R_VAL(r + 1, 0) = ED4R_VAL(r, 0) + (left % 3) - 1;
+    }
+    for (r = 1; r <= h; r ++) {
+        for (c = 1; c <= w; c ++) {
+            pi = ED4R_VAL(r - 1, c) + 1;
+            pd = ED4R_VAL(r, c - 1) + 1;
+            pr = ED4R_VAL(r - 1, c - 1) + ((eq & (1 << ((c - 1) * ED4R_T + r - 1)))?0:1);
+            ED4R_VAL(r, c) = MIN (pr, MIN (pi, pd));
+        }
+    }
+    if (NULL == ret) {
+        return;
+    }
+    ret->bottom = 0;
+    for (c = 0, pw = 1; c < w; c ++, pw *= 3) {
+        ret->bottom += (ED4R_VAL(h, c + 1) - ED4R_VAL(h, c) + 1) * pw;
+    }
+    ret->right = 0;
+    for (r = 0, pw = 1; r < h; r ++, pw *= 3) {
+        ret->right += (ED4R_VAL(r + 1, w) - ED4R_VAL(r, w) + 1) * pw;
+    }
+#undef ED4R_VAL
+}
+
+static void
+ed4r_table_init (void)
+{
+    int val[(ED4R_T + 1) * (ED4R_T + 1)];
+    ed4r_out_t *tab;
+    int top;
+    int left;
+    int eq;
+    int i;
+
+    for (i = 0; i < ED4R_NDELTA; i ++) {
+        g_ed4r_sum[i] = (i % 3) + (i / 3 % 3) + (i / 9 % 3) - 3;
+    }
+    tab = (ed4r_out_t *)malloc (sizeof (ed4r_out_t) * ED4R_NDELTA * ED4R_NDELTA * ED4R_NEQ);
+    if (NULL == tab) {
+        return;
+    }
+    for (top = 0; top < ED4R_NDELTA; top ++) {
+        for (left = 0; left < ED4R_NDELTA; left ++) {
+            for (eq = 0; eq < ED4R_NEQ; eq ++) {
+                ed4r_block (top, left, eq, ED4R_T, ED4R_T, val, &(tab[ED4R_KEY (top, left, eq)]));
+            }
+        }
+    }
+    g_ed4r_table = tab;
+}
+
+static int
+ed4r_wcscmp (const void *a, const void *b)
+{
+    wchar_t ca = *(const wchar_t *)a;
+    wchar_t cb = *(const wchar_t *)b;
+    return (ca < cb)?-1:((ca > cb)?1:0);
+}
+
+/**
+ * @brief 把字符换成类别号: b 中出现的字符为 1..K, 只在 a 中出现的字符为 0
+ *
+ * @return 返回 K, 失败返回 -1
+ */
+static ssize_t
+ed4r_classify (const wchar_t *stra, size_t lena, const wchar_t *strb, size_t lenb, uint32_t *clsa, uint32_t *clsb)
+{
+    wchar_t *alpha;
+    wchar_t *p;
+    size_t num;
+    size_t i;
+
+    alpha = (wchar_t *)malloc (sizeof (wchar_t) * (lenb + 1));
+    if (NULL == alpha) {
+        return -1;
+    }
+    memcpy (alpha, strb, sizeof (wchar_t) * lenb);
+    qsort (alpha, lenb, sizeof (wchar_t), ed4r_wcscmp);
+    for (num = 0, i = 0; i < lenb; i ++) {
+        if ((0 == num) || (alpha[num - 1] != alpha[i])) {
+            alpha[num ++] = alpha[i];
+        }
+    }
+    for (i = 0; i < lenb; i ++) {
+        p = (wchar_t *)bsearch (strb + i, alpha, num, sizeof (wchar_t), ed4r_wcscmp);
+        assert (NULL != p);
+        clsb[i] = (p - alpha) + 1;
+    }
+    for (i = 0; i < lena; i ++) {
+        p = (wchar_t *)bsearch (stra + i, alpha, num, sizeof (wchar_t), ed4r_wcscmp);
+        clsa[i] = ((NULL == p)?0:((p - alpha) + 1));
+    }
+    free (alpha);
+    return num;
+}
+
+/**
+ * @brief 按块计算整个矩阵
+ *
+ * @param keys : 若不为 NULL, 保存每个块的表索引, nbi x nbj 个
+ *
+ * @return 返回距离值, 失败返回 -1
+ */
+static int
+ed4r_fill (const wchar_t *stra, size_t lena, const wchar_t *strb, size_t lenb, uint32_t *keys)
+{
+    int val[(ED4R_T + 1) * (ED4R_T + 1)];
+    ed4r_out_t out;
+    uint32_t *clsa = NULL;
+    uint32_t *clsb = NULL;
+    uint8_t *mask = NULL;  /* the class -> the equal mask of the rows in the block row */
+    uint8_t *htop = NULL;  /* the deltas at the top of each block column */
+    size_t nbj;
+    size_t bi;
+    size_t bj;
+    size_t i;
+    size_t j;
+    ssize_t numcls;
+    uint32_t key;
+    int left;
+    int eq;
+    int w;
+    int h;
+    int r;
+    int c;
+    int ret = -1;
+
+    pthread_once (&g_ed4r_once, ed4r_table_init);
+    if (NULL == g_ed4r_table) {
+        return -1;
+    }
+    nbj = (lena + ED4R_T - 1) / ED4R_T;
+    clsa = (uint32_t *)malloc (sizeof (uint32_t) * (lena + 1));
+    clsb = (uint32_t *)malloc (sizeof (uint32_t) * (lenb + 1));
+    htop = (uint8_t *)malloc (sizeof (uint8_t) * (nbj + 1));
+    if ((NULL == clsa) || (NULL == clsb) || (NULL == htop)) {
+        goto end_fill;
+    }
+    numcls = ed4r_classify (stra, lena, strb, lenb, clsa, clsb);
+    if (numcls < 0) {
+        goto end_fill;
+    }
+    mask = (uint8_t *)calloc (numcls + 1, sizeof (uint8_t));
+    if (NULL == mask) {
+        goto end_fill;
+    }
+
+    /* 第0行: D[0][j] = j, 横向差值都是 +1 */
+    for (j = 0, bj = 0; j < lena; j += ED4R_T, bj ++) {
+        htop[bj] = g_ed4r_pow3[MIN (ED4R_T, lena - j)] - 1;
+    }
+    for (i = 0, bi = 0; i < lenb; i += ED4R_T, bi ++) {
+        h = MIN (ED4R_T, lenb - i);
+        for (r = 0; r < h; r ++) {
+            mask[clsb[i + r]] |= (1 << r);
+        }
+        /* 第0列: 纵向差值都是 +1 */
+        left = ED4R_NDELTA - 1;
+        for (j = 0, bj = 0; j < lena; j += ED4R_T, bj ++) {
+            w = MIN (ED4R_T, lena - j);
+            eq = 0;
+            for (c = 0; c < w; c ++) {
+                eq |= mask[clsa[j + c]] << (c * ED4R_T);
+            }
+            key = ED4R_KEY (htop[bj], left, eq);
+            if ((ED4R_T == w) && (ED4R_T == h)) {
+                out = g_ed4r_table[key];
+            } else {
+                ed4r_block (htop[bj], left, eq, w, h, val, &out);
+            }
+            if (NULL != keys) {
+                keys[bi * nbj + bj] = key;
+            }
+            htop[bj] = out.bottom;
+            left = out.right;
+        }
+        for (r = 0; r < h; r ++) {
+            mask[clsb[i + r]] = 0;
+        }
+    }
+    mask[0] = 0;
+
+    /* D[lenb][lena] = D[lenb][0] + 底部所有的横向差值 */
+    ret = lenb;
+    for (j = 0, bj = 0; j < lena; j += ED4R_T, bj ++) {
+        w = MIN (ED4R_T, lena - j);
+        /* the missing digits of a narrow block are 0, the delta -1 */
+        ret += g_ed4r_sum[htop[bj]] + (ED4R_T - w);
+    }
+
+end_fill:
+    free (mask);
+    free (htop);
+    free (clsb);
+    free (clsa);
+    return ret;
+}
+
+/**
+ * @brief 计算两个字符串的距离, Four Russians 版本
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 结果和 ed_edit_distance() 相同。每 3x3 个格子查一次表, 时间O(m*n)(约为逐格计算的 1/t), 空间O(m+n)。
+ * 和带状及 O(ND) 的算法不同，速度与两个字符串的差别大小无关。
+ */
+int
+ed_edit_distance_4r (strcmp_t *cmpinfo)
+{
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    int ret = -1;
+
+    assert (NULL != cmpinfo);
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL != stra) && (NULL != strb)) {
+        ret = ed4r_fill (stra, lena, strb, lenb, NULL);
+    }
+    free (stra);
+    free (strb);
+    return ret;
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, Four Russians 版本
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 结果和 ed_edit_distance_path() 完全相同(包括路径)。每个块只保存 4 字节的表索引，
+ * 回溯经过一个块时重新计算块内的值，按 ed_edit_distance_path() 的规则选择方向。
+ * 时间O(m*n)(约为逐格计算的 1/t), 空间O(m*n/t^2)
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_4r (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    int val[(ED4R_T + 1) * (ED4R_T + 1)];
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    uint32_t *keys = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    size_t nbj;
+    size_t curblk;
+    size_t blk;
+    size_t num;
+    size_t i;
+    size_t j;
+    size_t bi;
+    size_t bj;
+    int r;
+    int c;
+    int pi; /* Pinsert */
+    int pd; /* Pdelete */
+    int pr; /* Pignore/Preplace */
+    char flg_equ;
+    int ret = -1;
+
+    if (NULL == path) {
+        return ed_edit_distance_4r (cmpinfo);
+    }
+    assert (NULL != cmpinfo);
+    assert (NULL != ret_numpath);
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL == stra) || (NULL == strb)) {
+        goto end_4r;
+    }
+    nbj = (lena + ED4R_T - 1) / ED4R_T;
+    keys = (uint32_t *)malloc (sizeof (uint32_t) * (nbj * ((lenb + ED4R_T - 1) / ED4R_T) + 1));
+    if (NULL == keys) {
+        goto end_4r;
+    }
+    ret = ed4r_fill (stra, lena, strb, lenb, keys);
+    if (ret < 0) {
+        goto end_4r;
+    }
+
+    i = lenb;
+    j = lena;
+    num = lena + lenb;
+    curblk = (size_t)-1;
+    while (i > 0 || j > 0) {
+        assert (num > 0);
+        if (0 == i) {
+            path[-- num] = EDIS_DELETE;
+            j --;
+            continue;
+        }
+        if (0 == j) {
+            path[-- num] = EDIS_INSERT;
+            i --;
+            continue;
+        }
+        /* the cell (i,j) is inside the block (bi,bj), the top-left corner is (bi*t, bj*t) */
+        bi = (i - 1) / ED4R_T;
+        bj = (j - 1) / ED4R_T;
+        blk = bi * nbj + bj;
+        if (blk != curblk) {
+            ed4r_block (ED4R_KEY_TOP (keys[blk]), ED4R_KEY_LEFT (keys[blk]), ED4R_KEY_EQ (keys[blk]),
+                MIN (ED4R_T, lena - bj * ED4R_T), MIN (ED4R_T, lenb - bi * ED4R_T), val, NULL);
+            curblk = blk;
+        }
+        r = i - bi * ED4R_T;
+        c = j - bj * ED4R_T;
+        pi = val[(r - 1) * (ED4R_T + 1) + c] + 1;
+        pd = val[r * (ED4R_T + 1) + c - 1] + 1;
+        flg_equ = (stra[j - 1] == strb[i - 1]);
+        pr = val[(r - 1) * (ED4R_T + 1) + c - 1] + (flg_equ?0:1);
+        /* 和 ed_edit_distance_path() 的选择顺序一致 */
+        if (pr < pi && pr <= pd) {
+            path[-- num] = (flg_equ?EDIS_IGNORE:EDIS_REPLAC);
+            i --;
+            j --;
+        } else if (pi < pd) {
+            path[-- num] = EDIS_INSERT;
+            i --;
+        } else {
+            path[-- num] = EDIS_DELETE;
+            j --;
+        }
+    }
+    if (num > 0) {
+        memmove (path, path + num, sizeof (char) * (lena + lenb - num));
+    }
+    *ret_numpath = lena + lenb - num;
+    ed_numa_account ("Four Russians block keys", keys, sizeof (uint32_t) * nbj * ((lenb + ED4R_T - 1) / ED4R_T));
+
+end_4r:
+    free (keys);
+    free (stra);
+    free (strb);
+    return ret;
+}
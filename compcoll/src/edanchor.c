@@ -0,0 +1,384 @@
+/**
+ * @file    edanchor.c
+ * @brief   Edit distance path between the unique k-gram anchors
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#include <sys/types.h> /* ssize_t */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "editdistance.h"
+
+#define EDANCHOR_HASHBASE 1000003ULL
+
+/**
+ * 锚点: 在两个字符串中都只出现一次的长度为 k 的子串(k-gram)。
+ * 按在 b 中的位置排列所有锚点, 在 a 中的位置的最长递增子序列(patience sorting)就是一组互不交叉的锚点，
+ * 锚点之间的空隙再分别用 DP 计算。
+ * 古文中不重复的长段很多，一个很大的矩阵就变成了很多个很小的矩阵；但结果不一定是最优的。
+ */
+typedef struct _ed_kgram_t {
+    uint64_t hash;
+    const wchar_t *key; /* the first occurrence */
+    size_t posa;    /* the position of the last occurrence in a */
+    size_t posb;    /* the position of the last occurrence in b */
+    int cnta;       /* the number of occurrences in a */
+    int cntb;       /* the number of occurrences in b */
+} ed_kgram_t;
+
+typedef struct _ed_kgtable_t {
+    ed_kgram_t *items;
+    size_t mask;    /* the size of the table - 1 */
+    size_t klen;
+} ed_kgtable_t;
+
+/* 一段相同的字符: a[posa, posa + len) == b[posb, posb + len) */
+typedef struct _ed_segment_t {
+    size_t posa;
+    size_t posb;
+    size_t len;
+} ed_segment_t;
+
+/* 返回 k-gram 在表中的位置，不存在时为一个空位 */
+static size_t
+ed_kgtable_find (ed_kgtable_t *pt, const wchar_t *key, uint64_t hash)
+{
+    size_t idx = (size_t)(hash ^ (hash >> 29)) & pt->mask;
+    while (NULL != pt->items[idx].key) {
+        if ((pt->items[idx].hash == hash) && (0 == wmemcmp (pt->items[idx].key, key, pt->klen))) {
+            break;
+        }
+        idx = (idx + 1) & pt->mask;
+    }
+    return idx;
+}
+
+/* 把字符串的所有 k-gram 加入表中, right -- 0 为 a, 1 为 b; 若 ret_idx 不为 NULL, 记录每个 k-gram 在表中的位置 */
+static void
+ed_kgtable_add (ed_kgtable_t *pt, const wchar_t *str, size_t len, int right, size_t *ret_idx)
+{
+    uint64_t hash = 0;
+    uint64_t high = 1; /* EDANCHOR_HASHBASE ^ (klen - 1) */
+    size_t i;
+    size_t idx;
+    ed_kgram_t *pk;
+
+    for (i = 1; i < pt->klen; i ++) {
+        high *= EDANCHOR_HASHBASE;
+    }
+    for (i = 0; i < len; i ++) {
+        if (i >= pt->klen) {
+            hash -= high * (uint64_t)str[i - pt->klen];
+        }
+        hash = hash * EDANCHOR_HASHBASE + (uint64_t)str[i];
+        if (i + 1 < pt->klen) {
+            continue;
+        }
+        idx = ed_kgtable_find (pt, str + i + 1 - pt->klen, hash);
+        pk = pt->items + idx;
+        if (NULL == pk->key) {
+            pk->key = str + i + 1 - pt->klen;
+            pk->hash = hash;
+        }
+        if (right) {
+            pk->cntb ++;
+            pk->posb = i + 1 - pt->klen;
+        } else {
+            pk->cnta ++;
+            pk->posa = i + 1 - pt->klen;
+        }
+        if (NULL != ret_idx) {
+            ret_idx[i + 1 - pt->klen] = idx;
+        }
+    }
+}
+
+/**
+ * @brief 找到锚点, 合并成互不交叉的相同段
+ *
+ * @return 返回段的个数, 失败返回 -1
+ */
+static ssize_t
+ed_anchor_segments (const wchar_t *stra, size_t lena, const wchar_t *strb, size_t lenb, size_t klen, ed_segment_t **ret_seg)
+{
+    ed_kgtable_t table;
+    size_t *idxb = NULL;   /* the index in the table of each k-gram of b */
+    size_t *cand = NULL;   /* the position in b of the candidates */
+    size_t *tails = NULL;  /* tails[t] -- the last candidate of the increasing sequence of length t + 1 */
+    ssize_t *prev = NULL;  /* the previous candidate in the sequence */
+    ed_segment_t *seg = NULL;
+    size_t numcand = 0;
+    size_t numtails = 0;
+    ssize_t numseg = -1;
+    size_t sz;
+    size_t i;
+    size_t lo;
+    size_t hi;
+    ssize_t k;
+
+    memset (&table, 0, sizeof (table));
+    *ret_seg = NULL;
+    if ((lena < klen) || (lenb < klen)) {
+        return 0;
+    }
+    for (sz = 1; sz < 2 * (lena + lenb); sz <<= 1);
+    table.items = (ed_kgram_t *)calloc (sz, sizeof (ed_kgram_t));
+    table.mask = sz - 1;
+    table.klen = klen;
+    idxb = (size_t *)malloc (sizeof (size_t) * (lenb - klen + 1));
+    cand = (size_t *)malloc (sizeof (size_t) * (lenb - klen + 1));
+    tails = (size_t *)malloc (sizeof (size_t) * (lenb - klen + 1));
+    prev = (ssize_t *)malloc (sizeof (ssize_t) * (lenb - klen + 1));
+    if ((NULL == table.items) || (NULL == idxb) || (NULL == cand) || (NULL == tails) || (NULL == prev)) {
+        goto end_anchor;
+    }
+    ed_kgtable_add (&table, stra, lena, 0, NULL);
+    ed_kgtable_add (&table, strb, lenb, 1, idxb);
+
+    /* 候选锚点按在 b 中的位置排列, 求在 a 中位置的最长递增子序列 */
+    for (i = 0; i + klen <= lenb; i ++) {
+        ed_kgram_t *pk = table.items + idxb[i];
+        if ((1 != pk->cnta) || (1 != pk->cntb)) {
+            continue;
+        }
+        cand[numcand] = i;
+        lo = 0;
+        hi = numtails;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (table.items[idxb[cand[tails[mid]]]].posa < pk->posa) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        prev[numcand] = ((lo > 0)?(ssize_t)tails[lo - 1]:-1);
+        tails[lo] = numcand;
+        if (lo == numtails) {
+            numtails ++;
+        }
+        numcand ++;
+    }
+
+    /* 按顺序取出锚点, 同一对角线上相连或重叠的锚点合并成一段, 和前一段交叉的锚点丢弃 */
+    seg = (ed_segment_t *)malloc (sizeof (ed_segment_t) * (numtails + 1));
+    if (NULL == seg) {
+        goto end_anchor;
+    }
+    k = ((numtails > 0)?(ssize_t)tails[numtails - 1]:-1);
+    for (i = numtails; i > 0; i --) {
+        /* reuse tails[] for the chain in increasing order */
+        assert (k >= 0);
+        tails[i - 1] = k;
+        k = prev[k];
+    }
+    numseg = 0;
+    for (i = 0; i < numtails; i ++) {
+        size_t posb = cand[tails[i]];
+        size_t posa = table.items[idxb[posb]].posa;
+        if (numseg > 0) {
+            ed_segment_t *ps = seg + numseg - 1;
+            if ((posa - ps->posa == posb - ps->posb) && (posa <= ps->posa + ps->len)) {
+                ps->len = posa + klen - ps->posa;
+                continue;
+            }
+            if ((posa < ps->posa + ps->len) || (posb < ps->posb + ps->len)) {
+                continue;
+            }
+        }
+        seg[numseg].posa = posa;
+        seg[numseg].posb = posb;
+        seg[numseg].len = klen;
+        numseg ++;
+    }
+    *ret_seg = seg;
+    seg = NULL;
+
+end_anchor:
+    free (seg);
+    free (prev);
+    free (tails);
+    free (cand);
+    free (idxb);
+    free (table.items);
+    return numseg;
+}
+
+/* 空隙的子串, 通过原来的 strcmp_t 访问 */
+typedef struct _ed_gap_t {
+    strcmp_t *cmpinfo;
+    size_t off[2];
+    size_t len[2];
+} ed_gap_t;
+
+static int
+ed_gap_comp (void *userdata, size_t idx1, size_t idx2)
+{
+    ed_gap_t *pg = (ed_gap_t *)userdata;
+    return pg->cmpinfo->cb_comp (pg->cmpinfo->userdata_str, pg->off[0] + idx1, pg->off[1] + idx2);
+}
+
+static int
+ed_gap_length (void *userdata, int right)
+{
+    ed_gap_t *pg = (ed_gap_t *)userdata;
+    return pg->len[right % 2];
+}
+
+static wchar_t
+ed_gap_getval (void *userdata, int right, size_t idx)
+{
+    ed_gap_t *pg = (ed_gap_t *)userdata;
+    return pg->cmpinfo->cb_getval (pg->cmpinfo->userdata_str, right, pg->off[right % 2] + idx);
+}
+
+static int
+ed_gap_output (void *userdata, FILE *fp, int right, size_t idx)
+{
+    ed_gap_t *pg = (ed_gap_t *)userdata;
+    return pg->cmpinfo->cb_output (pg->cmpinfo->userdata_str, fp, right, pg->off[right % 2] + idx);
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, 只在锚点之间做 DP
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval, 其余的传给 cb_path)
+ * @param klen : 锚点的长度, 0 时不使用锚点
+ * @param cb_path : 计算空隙的函数, NULL 时为 ed_edit_distance_path_fast()
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 锚点越长越可靠, 但能找到的锚点越少。所有的锚点都按原样保留, 所以距离不一定是最小的。
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_anchor (strcmp_t *cmpinfo, size_t klen, ed_path_cb_t cb_path, char *path, size_t *ret_numpath)
+{
+    strcmp_t cmpgap;
+    ed_gap_t gap;
+    ed_segment_t *seg = NULL;
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    size_t numpath = 0;
+    size_t szgap;
+    size_t posa = 0;
+    size_t posb = 0;
+    ssize_t numseg = 0;
+    ssize_t s;
+    size_t i;
+    int ret = -1;
+    int r;
+
+    assert (NULL != cmpinfo);
+    assert (NULL != path);
+    assert (NULL != ret_numpath);
+    if (NULL == cb_path) {
+        cb_path = ed_edit_distance_path_fast;
+    }
+    if (klen < 1) {
+        return cb_path (cmpinfo, path, ret_numpath);
+    }
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL == stra) || (NULL == strb)) {
+        goto end_anchor;
+    }
+    numseg = ed_anchor_segments (stra, lena, strb, lenb, klen, &seg);
+    if (numseg < 0) {
+        goto end_anchor;
+    }
+
+    cmpgap = *cmpinfo;
+    cmpgap.userdata_str = &gap;
+    cmpgap.cb_comp = ed_gap_comp;
+    cmpgap.cb_len = ed_gap_length;
+    cmpgap.cb_getval = ed_gap_getval;
+    cmpgap.cb_output = ((NULL == cmpinfo->cb_output)?NULL:ed_gap_output);
+    gap.cmpinfo = cmpinfo;
+    ret = 0;
+    /* the last one is the gap after all of the segments */
+    for (s = 0; s <= numseg; s ++) {
+        gap.off[0] = posa;
+        gap.off[1] = posb;
+        gap.len[0] = ((s < numseg)?seg[s].posa:lena) - posa;
+        gap.len[1] = ((s < numseg)?seg[s].posb:lenb) - posb;
+        if ((gap.len[0] > 0) || (gap.len[1] > 0)) {
+            szgap = gap.len[0] + gap.len[1];
+            r = cb_path (&cmpgap, path + numpath, &szgap);
+            if (r < 0) {
+                ret = -1;
+                break;
+            }
+            ret += r;
+            numpath += szgap;
+        }
+        if (s < numseg) {
+            for (i = 0; i < seg[s].len; i ++) {
+                path[numpath ++] = EDIS_IGNORE;
+            }
+            posa = seg[s].posa + seg[s].len;
+            posb = seg[s].posb + seg[s].len;
+        }
+    }
+    if (ret >= 0) {
+        *ret_numpath = numpath;
+    }
+
+end_anchor:
+    free (seg);
+    free (stra);
+    free (strb);
+    return ret;
+}
+
+/**
+ * @brief 计算两个字符串中间部分的修改路径, 相同的前缀和后缀不修改
+ *
+ * @param cmpinfo : 中间部分(去掉相同的前缀和后缀)的访问接口
+ * @param szprefix : 相同前缀的长度
+ * @param szsuffix : 相同后缀的长度
+ * @param klen : 锚点的长度, 0 时不使用锚点
+ * @param cb_path : 计算中间部分的函数, NULL 时为 ed_edit_distance_path_fast()
+ * @param path : 修改路径, 依次为前缀, 中间部分, 后缀
+ * @param ret_numpath : 传入修改路径缓冲长度, 返回修改路径长度
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 失败时不写后缀, 因为中间部分的长度未知。
+ *    the buffer of the path should be >= szprefix+szsuffix+strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_trim (strcmp_t *cmpinfo, size_t szprefix, size_t szsuffix, size_t klen, ed_path_cb_t cb_path, char *path, size_t *ret_numpath)
+{
+    size_t szmid;
+    int ret = 0;
+
+    assert (NULL != cmpinfo);
+    assert (NULL != path);
+    assert (NULL != ret_numpath);
+    if (*ret_numpath < szprefix + szsuffix) {
+        return -1;
+    }
+    memset (path, EDIS_IGNORE, szprefix);
+    szmid = 0;
+    if ((cmpinfo->cb_len (cmpinfo->userdata_str, 0) > 0) || (cmpinfo->cb_len (cmpinfo->userdata_str, 1) > 0)) {
+        szmid = *ret_numpath - szprefix - szsuffix;
+        ret = ed_edit_distance_path_anchor (cmpinfo, klen, cb_path, path + szprefix, &szmid);
+        if (ret < 0) {
+            return -1;
+        }
+    }
+    memset (path + szprefix + szmid, EDIS_IGNORE, szsuffix);
+    *ret_numpath = szprefix + szmid + szsuffix;
+    return ret;
+}
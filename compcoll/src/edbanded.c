@@ -0,0 +1,342 @@
+/**
+ * @file    edbanded.c
+ * @brief   Banded edit distance with band doubling (E. Ukkonen 1985)
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "editdistance.h"
+#include "ednuma.h"
+
+#define EDBAND_INF   (INT_MAX / 2)
+#define EDBAND_INITK 32 /* the initial threshold of the band */
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+#define MAX(a,b) (((a)>(b))?(a):(b))
+
+/**
+ * 带状区域: 只计算对角线编号 d = j - i 在 [dmin, dmax] 之间的格子。
+ * 经过格子 (i,j) 的路径代价至少为 |d| + |delta - d|, delta = lena - lenb,
+ * 所以如果带内求得的距离不超过 k, 且带包含所有满足 |d| + |delta - d| <= k 的对角线，该距离就是最优的。
+ *
+ * 第 i 行的第 c 个格子对应 j = i + dmin + c。
+ */
+typedef struct _ed_band_t {
+    int dmin;
+    int dmax;
+    int width;  /* dmax - dmin + 1 */
+} ed_band_t;
+
+static void
+ed_band_setup (ed_band_t *pb, int lena, int lenb, int k)
+{
+    int delta = lena - lenb;
+    int t = (k - abs (delta)) / 2;
+
+    assert (k >= abs (delta));
+    pb->dmin = MAX (MIN (0, delta) - t, -lenb);
+    pb->dmax = MIN (MAX (0, delta) + t, lena);
+    pb->width = pb->dmax - pb->dmin + 1;
+}
+
+/* 带是否已经覆盖整个矩阵 */
+static int
+ed_band_isfull (ed_band_t *pb, int lena, int lenb)
+{
+    return ((pb->dmin <= -lenb) && (pb->dmax >= lena));
+}
+
+/**
+ * @brief 计算带内所有格子
+ *
+ * @param dir : 若不为 NULL, 存储每个格子的方向, (lenb + 1) * width 个
+ * @param rows : 两行的缓冲, 2 * width 个
+ * @param bound : 若 >= 0, 当一行中所有格子都无法在 bound 之内到达终点时提前结束
+ *
+ * @return 返回带内的距离值 D[lenb][lena], 提前结束时返回 EDBAND_INF
+ */
+static int
+ed_band_fill (const wchar_t *stra, int lena, const wchar_t *strb, int lenb, ed_band_t *pb, char *dir, int *rows, int bound)
+{
+    int *prev = rows;
+    int *cur = rows + pb->width;
+    int *tmp;
+    int i;
+    int j;
+    int c;
+    int pi; /* Pinsert */
+    int pd; /* Pdelete */
+    int pr; /* Pignore/Preplace */
+    char flg_equ;
+    char action;
+    int lowest;
+
+    for (c = 0; c < pb->width; c ++) {
+        j = pb->dmin + c;
+        if (j < 0 || j > lena) {
+            prev[c] = EDBAND_INF;
+            action = EDIS_NONE;
+        } else {
+            prev[c] = j;
+            action = (j > 0)?EDIS_DELETE:EDIS_NONE;
+        }
+        if (NULL != dir) {
+            dir[c] = action;
+        }
+    }
+    for (i = 1; i <= lenb; i ++) {
+        lowest = EDBAND_INF;
+        for (c = 0; c < pb->width; c ++) {
+            j = i + pb->dmin + c;
+            if (j < 0 || j > lena) {
+                cur[c] = EDBAND_INF;
+                action = EDIS_NONE;
+            } else if (0 == j) {
+                cur[c] = i;
+                action = EDIS_INSERT;
+            } else {
+                pi = (c + 1 < pb->width)?(prev[c + 1] + 1):EDBAND_INF;
+                pd = (c > 0)?(cur[c - 1] + 1):EDBAND_INF;
+                flg_equ = (stra[j - 1] == strb[i - 1]);
+                pr = prev[c] + (flg_equ?0:1);
+                /* 和 ed_edit_distance_path() 的选择顺序一致 */
+                if (pr < pi && pr <= pd) {
+                    cur[c] = pr;
+                    action = (flg_equ?EDIS_IGNORE:EDIS_REPLAC);
+                } else if (pi < pd) {
+                    cur[c] = pi;
+                    action = EDIS_INSERT;
+                } else {
+                    cur[c] = pd;
+                    action = EDIS_DELETE;
+                }
+            }
+            if (NULL != dir) {
+                dir[(size_t)i * pb->width + c] = action;
+            }
+            /* 从 (i,j) 到终点至少还需要 |delta - d| 步 */
+            if (bound >= 0 && cur[c] < EDBAND_INF) {
+                lowest = MIN (lowest, cur[c] + abs (lena - lenb - pb->dmin - c));
+            }
+        }
+        if (bound >= 0 && lowest > bound) {
+            return EDBAND_INF;
+        }
+        tmp = prev;
+        prev = cur;
+        cur = tmp;
+    }
+    return prev[lena - lenb - pb->dmin];
+}
+
+/* 沿方向回溯出路径 */
+static size_t
+ed_band_traceback (ed_band_t *pb, int lena, int lenb, const char *dir, char *path)
+{
+    int i = lenb;
+    int c = lena - lenb - pb->dmin;
+    size_t num = lena + lenb;
+    char action;
+
+    while (num > 0) {
+        action = dir[(size_t)i * pb->width + c];
+        if (EDIS_NONE == action) {
+            break;
+        }
+        path[-- num] = action;
+        switch (action) {
+        case EDIS_INSERT:
+            i --;
+            c ++;
+            break;
+        case EDIS_DELETE:
+            c --;
+            break;
+        case EDIS_REPLAC:
+        case EDIS_IGNORE:
+            i --;
+            break;
+        default:
+            assert (0);
+            break;
+        }
+        assert (c >= 0 && c < pb->width);
+    }
+    if (num > 0) {
+        memmove (path, path + num, sizeof (char) * (lena + lenb - num));
+    }
+    return lena + lenb - num;
+}
+
+/* 带宽每次加倍, 直到结果被证明是最优的 */
+static int
+ed_banded (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    ed_band_t band;
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    int *rows = NULL;
+    char *dir = NULL;
+    void *newbuf;
+    int k;
+    int ret = -1;
+
+    assert (NULL != cmpinfo);
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL == stra) || (NULL == strb)) {
+        goto end_banded;
+    }
+
+    for (k = EDBAND_INITK; k < abs ((int)lena - (int)lenb); k *= 2);
+    for (;;) {
+        ed_band_setup (&band, lena, lenb, k);
+        newbuf = realloc (rows, sizeof (int) * band.width * 2);
+        if (NULL == newbuf) {
+            /* ret may hold the distance of the last band */
+            ret = -1;
+            goto end_banded;
+        }
+        rows = (int *)newbuf;
+        if (NULL != path) {
+            newbuf = realloc (dir, sizeof (char) * (lenb + 1) * band.width);
+            if (NULL == newbuf) {
+                ret = -1;
+                goto end_banded;
+            }
+            dir = (char *)newbuf;
+        }
+        ret = ed_band_fill (stra, lena, strb, lenb, &band, dir, rows, -1);
+        if (ret <= k || ed_band_isfull (&band, lena, lenb)) {
+            break;
+        }
+        k *= 2;
+    }
+    if (NULL != path) {
+        *ret_numpath = ed_band_traceback (&band, lena, lenb, dir, path);
+        ed_numa_account ("band of directions", dir, sizeof (char) * (lenb + 1) * band.width);
+    }
+
+end_banded:
+    if (NULL != dir) {
+        free (dir);
+    }
+    if (NULL != rows) {
+        free (rows);
+    }
+    if (NULL != stra) {
+        free (stra);
+    }
+    if (NULL != strb) {
+        free (strb);
+    }
+    return ret;
+}
+
+/**
+ * @brief 计算两个字符串的距离, 带状版本
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 结果和 ed_edit_distance() 相同。从一个窄带开始，每次带宽加倍，直到带内的距离不超过带宽。
+ * 时间O((m+n)*D), 空间O(D)，D 为距离值。
+ */
+int
+ed_edit_distance_banded (strcmp_t *cmpinfo)
+{
+    return ed_banded (cmpinfo, NULL, NULL);
+}
+
+/**
+ * @brief 判断两个字符串的距离是否不超过 k
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ * @param k : 距离的上限
+ *
+ * @return 距离不超过 k 时返回距离值, 超过 k 或失败返回 -1
+ *
+ * 只计算宽度为 k 的带，长度差超过 k 时不需要计算；每算完一行，
+ * 如果所有格子的值加上到终点的最少步数都超过 k，就立即返回。不相关的两个字符串通常在前几行就被排除。
+ * 时间O((m+n)*k), 空间O(k)。
+ */
+int
+ed_edit_distance_bounded (strcmp_t *cmpinfo, int k)
+{
+    ed_band_t band;
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    int *rows = NULL;
+    int ret = -1;
+
+    assert (NULL != cmpinfo);
+    if (k < 0) {
+        return -1;
+    }
+    lena = cmpinfo->cb_len (cmpinfo->userdata_str, 0);
+    lenb = cmpinfo->cb_len (cmpinfo->userdata_str, 1);
+    if (abs ((int)lena - (int)lenb) > k) {
+        return -1;
+    }
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL == stra) || (NULL == strb)) {
+        goto end_bounded;
+    }
+    ed_band_setup (&band, lena, lenb, k);
+    rows = (int *)malloc (sizeof (int) * band.width * 2);
+    if (NULL == rows) {
+        goto end_bounded;
+    }
+    ret = ed_band_fill (stra, lena, strb, lenb, &band, NULL, rows, k);
+    if (ret > k) {
+        ret = -1;
+    }
+
+end_bounded:
+    if (NULL != rows) {
+        free (rows);
+    }
+    if (NULL != stra) {
+        free (stra);
+    }
+    if (NULL != strb) {
+        free (strb);
+    }
+    return ret;
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, 带状版本
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 结果和 ed_edit_distance_path() 相同(路径也相同，除非带外有同样代价的路径)。
+ * 只保存带内格子的方向，时间和空间都是 O((m+n)*D)。
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_banded (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    if (NULL == path) {
+        return ed_edit_distance_banded (cmpinfo);
+    }
+    assert (NULL != ret_numpath);
+    return ed_banded (cmpinfo, path, ret_numpath);
+}
@@ -0,0 +1,551 @@
+/**
+ * @file    edbench.c
+ * @brief   Benchmark the edit distance algorithms
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#define _GNU_SOURCE 1
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <assert.h>
+
+#include "editdistance.h"
+#include "mymat.h"
+#include "edmatrix.h"
+
+typedef struct _benchstr_t {
+    wchar_t *str[2];
+    size_t len[2];
+} benchstr_t;
+
+/* idx1 -- the index of the `left' string; idx2 -- right */
+static int
+bench_comp (void *userdata, size_t idx1, size_t idx2)
+{
+    benchstr_t * pbs = (benchstr_t *)userdata;
+    if (pbs->str[0][idx1] == pbs->str[1][idx2]) {
+        return 0;
+    }
+    if (pbs->str[0][idx1] < pbs->str[1][idx2]) {
+        return -1;
+    }
+    return 1;
+}
+
+/* 0 -- `left' string, 1 -- `right' string */
+static int
+bench_length (void *userdata, int right)
+{
+    benchstr_t * pbs = (benchstr_t *)userdata;
+    return pbs->len[right % 2];
+}
+
+/* idx -- the index of the string; right -- 0 -- `left' string, 1 -- `right' string */
+static wchar_t
+bench_getval (void *userdata, int right, size_t idx)
+{
+    benchstr_t * pbs = (benchstr_t *)userdata;
+    return pbs->str[right % 2][idx];
+}
+
+/**********************************************************************************/
+static int g_bench_threads = 0;
+
+static int
+bench_full (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path (cmpinfo, path, ret_numpath);
+}
+
+/* the same as bench_full(), with the matrices of the smallest element, in the layout and the fill order given */
+static int
+bench_mymat (strcmp_t *cmpinfo, char flg_tiled, char flg_recursive, char flg_nozero, char *path, size_t *ret_numpath)
+{
+    strcmp_t cmpcompact;
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    int ret;
+
+    mymat_init_compact (&mat1);
+    mymat_init_compact (&mat2);
+    mymat_set_tiled (&mat1, flg_tiled);
+    mymat_set_tiled (&mat2, flg_tiled);
+    mymat_set_nozero (&mat1, flg_nozero);
+    mymat_set_nozero (&mat2, flg_nozero);
+    cmpcompact = *cmpinfo;
+    cmpcompact.userdata_matrix  = &mat1;
+    cmpcompact.userdata_matrix2 = &mat2;
+    if (flg_recursive) {
+        ret = ed_edit_distance_path_recursive (&cmpcompact, path, ret_numpath);
+    } else {
+        ret = ed_edit_distance_path (&cmpcompact, path, ret_numpath);
+    }
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+static int
+bench_full_compact (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return bench_mymat (cmpinfo, 0, 0, 0, path, ret_numpath);
+}
+
+static int
+bench_full_nozero (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return bench_mymat (cmpinfo, 0, 0, 1, path, ret_numpath);
+}
+
+static int
+bench_full_tiled (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return bench_mymat (cmpinfo, 1, 0, 0, path, ret_numpath);
+}
+
+static int
+bench_recursive (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return bench_mymat (cmpinfo, 0, 1, 0, path, ret_numpath);
+}
+
+static int
+bench_recursive_tiled (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return bench_mymat (cmpinfo, 1, 1, 0, path, ret_numpath);
+}
+
+/* the same as bench_full_compact(), the values by the deltas in 2.5 bits per cell */
+static int
+bench_full_delta (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    strcmp_t cmpdelta;
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    int ret;
+
+    mymat_init_delta (&mat1);
+    mymat_init_compact (&mat2);
+    mymat_set_nozero (&mat1, 1);
+    mymat_set_nozero (&mat2, 1);
+    cmpdelta = *cmpinfo;
+    cmpdelta.userdata_matrix  = &mat1;
+    cmpdelta.userdata_matrix2 = &mat2;
+    ret = ed_edit_distance_path (&cmpdelta, path, ret_numpath);
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+/* the same as bench_mymat(), with the edmat_* matrices of the narrowest elements, the directions in 2 bits */
+static int
+bench_edmat (strcmp_t *cmpinfo, int layout, char flg_recursive, char *path, size_t *ret_numpath)
+{
+    strcmp_t cmpnarrow;
+    int lena = cmpinfo->cb_len (cmpinfo->userdata_str, 0);
+    int lenb = cmpinfo->cb_len (cmpinfo->userdata_str, 1);
+    int ret = -1;
+
+    cmpnarrow = *cmpinfo;
+    cmpnarrow.userdata_matrix  = edmat_create (edmat_type_fit (0, (lena > lenb)?lena:lenb), layout);
+    cmpnarrow.userdata_matrix2 = edmat_create (EDMAT_BIT2, layout);
+    cmpnarrow.cb_matget  = edmat_get;
+    cmpnarrow.cb_matset  = edmat_set;
+    cmpnarrow.cb_matresz = edmat_resize;
+    if ((NULL != cmpnarrow.userdata_matrix) && (NULL != cmpnarrow.userdata_matrix2)) {
+        if (flg_recursive) {
+            ret = ed_edit_distance_path_recursive (&cmpnarrow, path, ret_numpath);
+        } else {
+            ret = ed_edit_distance_path (&cmpnarrow, path, ret_numpath);
+        }
+    }
+    edmat_destroy (cmpnarrow.userdata_matrix);
+    edmat_destroy (cmpnarrow.userdata_matrix2);
+    return ret;
+}
+
+static int
+bench_full_edmat (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return bench_edmat (cmpinfo, EDMAT_ROWS, 0, path, ret_numpath);
+}
+
+static int
+bench_recursive_edmat (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return bench_edmat (cmpinfo, EDMAT_TILED, 1, path, ret_numpath);
+}
+
+/* the same as bench_full_compact(), only every sqrt(n)-th row is kept */
+static int
+bench_checkpoint (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    strcmp_t cmpcompact;
+    mymatrix_t mat1;
+    int ret;
+
+    mymat_init_compact (&mat1);
+    cmpcompact = *cmpinfo;
+    cmpcompact.userdata_matrix  = &mat1;
+    ret = ed_edit_distance_path_checkpoint (&cmpcompact, 0, path, ret_numpath);
+    mymat_clear (&mat1);
+    return ret;
+}
+
+static int
+bench_full_fast (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_fast (cmpinfo, path, ret_numpath);
+}
+
+static int
+bench_simd_scalar (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_simd (cmpinfo, EDSIMD_SCALAR, path, ret_numpath);
+}
+
+static int
+bench_simd_sse41 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    if (ed_simd_detect () < EDSIMD_SSE41) {
+        return -2;
+    }
+    return ed_edit_distance_path_simd (cmpinfo, EDSIMD_SSE41, path, ret_numpath);
+}
+
+static int
+bench_simd_avx2 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    if (ed_simd_detect () < EDSIMD_AVX2) {
+        return -2;
+    }
+    return ed_edit_distance_path_simd (cmpinfo, EDSIMD_AVX2, path, ret_numpath);
+}
+
+static int
+bench_tiled (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_tiled (cmpinfo, g_bench_threads, path, ret_numpath);
+}
+
+static int
+bench_linear (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_linear (cmpinfo, path, ret_numpath);
+}
+
+static int
+bench_linear_mt (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_linear_mt (cmpinfo, g_bench_threads, path, ret_numpath);
+}
+
+static int
+bench_banded (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_banded (cmpinfo, path, ret_numpath);
+}
+
+static int
+bench_myers (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_myers (cmpinfo, path, ret_numpath);
+}
+
+static int
+bench_lv (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_lv (cmpinfo, path, ret_numpath);
+}
+
+static int
+bench_bitpar (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_bitpar (cmpinfo, path, ret_numpath);
+}
+
+static int
+bench_4r (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_4r (cmpinfo, path, ret_numpath);
+}
+
+static int
+bench_dist (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance (cmpinfo);
+}
+
+static int
+bench_dist_fast (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_fast (cmpinfo);
+}
+
+static int
+bench_dist_bitpar (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_bitpar (cmpinfo);
+}
+
+static int
+bench_dist_4r (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_4r (cmpinfo);
+}
+
+static int
+bench_dist_banded (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_banded (cmpinfo);
+}
+
+#define BENCH_BATCH 16 /* the pairs in the batch tests */
+
+/* the distances of BENCH_BATCH copies of the pair, one by one */
+static int
+bench_dist_x16 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    int i;
+    int ret = -1;
+    for (i = 0; i < BENCH_BATCH; i ++) {
+        ret = ed_edit_distance_bitpar (cmpinfo);
+    }
+    return ret;
+}
+
+/* the distances of BENCH_BATCH copies of the pair, in one batch */
+static int
+bench_dist_batch (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    strcmp_t *pairs[BENCH_BATCH];
+    int dist[BENCH_BATCH];
+    int i;
+    for (i = 0; i < BENCH_BATCH; i ++) {
+        pairs[i] = cmpinfo;
+    }
+    if (ed_edit_distance_batch (pairs, BENCH_BATCH, EDSIMD_AUTO, dist) < 0) {
+        return -1;
+    }
+    return dist[BENCH_BATCH - 1];
+}
+
+typedef int (* bench_func_t) (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+
+typedef struct _bench_item_t {
+    const char *name;
+    bench_func_t func;
+} bench_item_t;
+
+static bench_item_t g_bench_items[] = {
+    { "full",        bench_full },
+    { "full-compact", bench_full_compact },
+    { "full-nozero", bench_full_nozero },
+    { "full-tiled",  bench_full_tiled },
+    { "full-delta",  bench_full_delta },
+    { "recursive",   bench_recursive },
+    { "recursive-tiled", bench_recursive_tiled },
+    { "full-edmat",  bench_full_edmat },
+    { "recursive-edmat", bench_recursive_edmat },
+    { "full-fast",   bench_full_fast },
+    { "checkpoint",  bench_checkpoint },
+    { "simd-scalar", bench_simd_scalar },
+    { "simd-sse41",  bench_simd_sse41 },
+    { "simd-avx2",   bench_simd_avx2 },
+    { "tiled",       bench_tiled },
+    { "linear",      bench_linear },
+    { "linear-mt",   bench_linear_mt },
+    { "banded",      bench_banded },
+    { "myers",       bench_myers },
+    { "lv",          bench_lv },
+    { "bitpar",      bench_bitpar },
+    { "4r",          bench_4r },
+    { "dist",        bench_dist },
+    { "dist-fast",   bench_dist_fast },
+    { "dist-bitpar", bench_dist_bitpar },
+    { "dist-banded", bench_dist_banded },
+    { "dist-4r",     bench_dist_4r },
+    { "dist-x16",    bench_dist_x16 },
+    { "dist-batch",  bench_dist_batch },
+};
+
+#define NUM_ITEMS(a) (sizeof(a)/sizeof(a[0]))
+
+static double
+bench_now (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* generate the string b by changing permille/1000 chars of a */
+static void
+bench_generate (benchstr_t *pbs, size_t len, int permille, int alphabet)
+{
+    size_t i;
+    wchar_t ch;
+    int r;
+
+    pbs->str[0] = (wchar_t *)malloc (sizeof (wchar_t) * (len + 1));
+    pbs->str[1] = (wchar_t *)malloc (sizeof (wchar_t) * (len * 2 + 1));
+    assert (NULL != pbs->str[0]);
+    assert (NULL != pbs->str[1]);
+    pbs->len[0] = len;
+    pbs->len[1] = 0;
+    for (i = 0; i < len; i ++) {
+        pbs->str[0][i] = 0x4E00 + rand () % alphabet;
+    }
+    for (i = 0; i < len; i ++) {
+        ch = pbs->str[0][i];
+        r = rand () % 1000;
+        if (r < permille) {
+            switch (r % 3) {
+            case 0: /* delete */
+                continue;
+            case 1: /* insert */
+                pbs->str[1][pbs->len[1] ++] = 0x4E00 + rand () % alphabet;
+                break;
+            case 2: /* replace */
+                ch = 0x4E00 + rand () % alphabet;
+                break;
+            }
+        }
+        pbs->str[1][pbs->len[1] ++] = ch;
+    }
+}
+
+static void
+help (char *progname)
+{
+    size_t i;
+    fprintf (stderr, "Usage: \n"
+        "\t%s [options] [algorithm ...]\n"
+        , basename(progname));
+    fprintf (stderr, "\nOptions:\n");
+    fprintf (stderr, "\t-n\tthe length of the strings (default 5000)\n");
+    fprintf (stderr, "\t-p\tthe changes in permille (default 10)\n");
+    fprintf (stderr, "\t-s\tthe size of the alphabet (default 3000)\n");
+    fprintf (stderr, "\t-r\tthe rounds of each test (default 3)\n");
+    fprintf (stderr, "\t-j\tthe number of threads (default: the number of CPUs)\n");
+    fprintf (stderr, "\t-h\tPrint this message.\n");
+    fprintf (stderr, "\nAlgorithms:\n\t");
+    for (i = 0; i < NUM_ITEMS(g_bench_items); i ++) {
+        fprintf (stderr, " %s", g_bench_items[i].name);
+    }
+    fprintf (stderr, "\n");
+}
+
+int
+main (int argc, char * argv[])
+{
+    benchstr_t bstr;
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    strcmp_t cmpinfo;
+    size_t len = 5000;
+    int permille = 10;
+    int alphabet = 3000;
+    int rounds = 3;
+    char * path = NULL;
+    size_t szpath;
+    size_t i;
+    int r;
+    int c;
+    int ret = 0;
+    double tm;
+    double tmbest;
+
+    while ((c = getopt (argc, argv, "n:p:s:r:j:h")) != EOF) {
+        switch (c) {
+        case 'n':
+            len = atoi (optarg);
+            break;
+        case 'p':
+            permille = atoi (optarg);
+            break;
+        case 's':
+            alphabet = atoi (optarg);
+            if (alphabet < 1) {
+                alphabet = 1;
+            }
+            break;
+        case 'r':
+            rounds = atoi (optarg);
+            break;
+        case 'j':
+            g_bench_threads = atoi (optarg);
+            break;
+        case 'h':
+        default:
+            help (argv[0]);
+            exit (0);
+            break;
+        }
+    }
+
+    srand (1);
+    bench_generate (&bstr, len, permille, alphabet);
+    mymat_init (&mat1);
+    mymat_init (&mat2);
+    memset (&cmpinfo, 0, sizeof (cmpinfo));
+    cmpinfo.userdata_str = &bstr;
+    cmpinfo.cb_comp = bench_comp;
+    cmpinfo.cb_len  = bench_length;
+    cmpinfo.cb_getval = bench_getval;
+    cmpinfo.userdata_matrix  = &mat1;
+    cmpinfo.userdata_matrix2 = &mat2;
+    cmpinfo.cb_matget  = mymat_get;
+    cmpinfo.cb_matset  = mymat_set;
+    cmpinfo.cb_matresz = mymat_resize;
+
+    path = (char *)malloc (bstr.len[0] + bstr.len[1] + 1);
+    assert (NULL != path);
+
+    printf ("# len a=%zu, b=%zu, changes=%d/1000, alphabet=%d, simd=%d\n", bstr.len[0], bstr.len[1], permille, alphabet, ed_simd_detect ());
+    printf ("# %-14s %10s %12s\n", "algorithm", "distance", "seconds");
+    for (i = 0; i < NUM_ITEMS(g_bench_items); i ++) {
+        if (optind < argc) {
+            for (c = optind; c < argc; c ++) {
+                if (0 == strcmp (argv[c], g_bench_items[i].name)) {
+                    break;
+                }
+            }
+            if (c >= argc) {
+                continue;
+            }
+        }
+        tmbest = -1;
+        for (r = 0; r < rounds; r ++) {
+            szpath = bstr.len[0] + bstr.len[1];
+            tm = bench_now ();
+            ret = g_bench_items[i].func (&cmpinfo, path, &szpath);
+            tm = bench_now () - tm;
+            if (tmbest < 0 || tm < tmbest) {
+                tmbest = tm;
+            }
+            if (ret < -1) {
+                break;
+            }
+        }
+        if (ret < -1) {
+            printf ("  %-14s %10s\n", g_bench_items[i].name, "n/a");
+            continue;
+        }
+        printf ("  %-14s %10d %12.6f\n", g_bench_items[i].name, ret, tmbest);
+    }
+
+    free (path);
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    free (bstr.str[0]);
+    free (bstr.str[1]);
+    return 0;
+}
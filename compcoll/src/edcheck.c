@@ -0,0 +1,1500 @@
+/**
+ * @file    edcheck.c
+ * @brief   Check the edit distance algorithms against the full matrix, run by "make check"
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#define _GNU_SOURCE 1
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h> /* sysconf() */
+#include <assert.h>
+
+#include "editdistance.h"
+#include "edmatrix.h"
+#include "ednuma.h"
+#include "mymat.h"
+
+typedef struct _checkstr_t {
+    wchar_t *str[2];
+    size_t len[2];
+} checkstr_t;
+
+/* idx1 -- the index of the `left' string; idx2 -- right */
+static int
+check_comp (void *userdata, size_t idx1, size_t idx2)
+{
+    checkstr_t * pcs = (checkstr_t *)userdata;
+    if (pcs->str[0][idx1] == pcs->str[1][idx2]) {
+        return 0;
+    }
+    if (pcs->str[0][idx1] < pcs->str[1][idx2]) {
+        return -1;
+    }
+    return 1;
+}
+
+/* 0 -- `left' string, 1 -- `right' string */
+static int
+check_length (void *userdata, int right)
+{
+    checkstr_t * pcs = (checkstr_t *)userdata;
+    return pcs->len[right % 2];
+}
+
+/* idx -- the index of the string; right -- 0 -- `left' string, 1 -- `right' string */
+static wchar_t
+check_getval (void *userdata, int right, size_t idx)
+{
+    checkstr_t * pcs = (checkstr_t *)userdata;
+    return pcs->str[right % 2][idx];
+}
+
+/**********************************************************************************/
+/* the random strings of the lengths lena and lenb, the chars in [0x4E00, 0x4E00 + alphabet) */
+static int
+check_generate (checkstr_t *pcs, size_t lena, size_t lenb, int alphabet)
+{
+    size_t i;
+    int k;
+
+    pcs->str[0] = (wchar_t *)malloc (sizeof (wchar_t) * (lena + 1));
+    pcs->str[1] = (wchar_t *)malloc (sizeof (wchar_t) * (lenb + 1));
+    if ((NULL == pcs->str[0]) || (NULL == pcs->str[1])) {
+        free (pcs->str[0]);
+        free (pcs->str[1]);
+        return -1;
+    }
+    pcs->len[0] = lena;
+    pcs->len[1] = lenb;
+    for (k = 0; k < 2; k ++) {
+        for (i = 0; i < pcs->len[k]; i ++) {
+            pcs->str[k][i] = 0x4E00 + rand () % alphabet;
+        }
+    }
+    return 0;
+}
+
+static void
+check_free (checkstr_t *pcs)
+{
+    free (pcs->str[0]);
+    free (pcs->str[1]);
+}
+
+static void
+check_setup (strcmp_t *cmpinfo, checkstr_t *pcs, mymatrix_t *mat1, mymatrix_t *mat2)
+{
+    memset (cmpinfo, 0, sizeof (*cmpinfo));
+    cmpinfo->userdata_str = pcs;
+    cmpinfo->cb_comp = check_comp;
+    cmpinfo->cb_len  = check_length;
+    cmpinfo->cb_getval = check_getval;
+    cmpinfo->userdata_matrix  = mat1;
+    cmpinfo->userdata_matrix2 = mat2;
+    cmpinfo->cb_matget  = mymat_get;
+    cmpinfo->cb_matset  = mymat_set;
+    cmpinfo->cb_matresz = mymat_resize;
+}
+
+/* replay the path against the strings, return the cost of the path, or -1 if it doesn't turn the `left' string to the `right' one */
+static int
+check_replay (const checkstr_t *pcs, const char *path, size_t num)
+{
+    size_t x = 0; /* the index of the `left' string */
+    size_t y = 0; /* the index of the `right' string */
+    size_t i;
+    int cost = 0;
+
+    for (i = 0; i < num; i ++) {
+        switch (path[i]) {
+        case EDIS_NONE:
+            break;
+        case EDIS_INSERT:
+            if (y >= pcs->len[1]) {
+                return -1;
+            }
+            y ++;
+            cost ++;
+            break;
+        case EDIS_DELETE:
+            if (x >= pcs->len[0]) {
+                return -1;
+            }
+            x ++;
+            cost ++;
+            break;
+        case EDIS_REPLAC:
+        case EDIS_IGNORE:
+            if ((x >= pcs->len[0]) || (y >= pcs->len[1])) {
+                return -1;
+            }
+            if ((EDIS_IGNORE == path[i]) != (pcs->str[0][x] == pcs->str[1][y])) {
+                return -1;
+            }
+            if (EDIS_REPLAC == path[i]) {
+                cost ++;
+            }
+            x ++;
+            y ++;
+            break;
+        default:
+            return -1;
+        }
+    }
+    if ((x != pcs->len[0]) || (y != pcs->len[1])) {
+        return -1;
+    }
+    return cost;
+}
+
+#define CHECK_EXACT 0x00 /*!< the distance is the minimal one */
+#define CHECK_UPPER 0x01 /*!< the distance may be larger than the minimal one */
+#define CHECK_INDEL 0x02 /*!< insert and delete only, the distance is lena + lenb - 2 * LCS */
+#define CHECK_SAME  0x04 /*!< the path is the same as ed_edit_distance_path() byte for byte */
+
+/* the distance with the inserts and deletes only, by the LCS in two rows */
+static int
+check_indel_distance (const checkstr_t *pcs)
+{
+    size_t *row0;
+    size_t *row1;
+    size_t *tmp;
+    size_t i;
+    size_t j;
+    int ret;
+
+    row0 = (size_t *)calloc (pcs->len[0] + 1, sizeof (size_t));
+    row1 = (size_t *)calloc (pcs->len[0] + 1, sizeof (size_t));
+    if ((NULL == row0) || (NULL == row1)) {
+        free (row0);
+        free (row1);
+        return -1;
+    }
+    for (i = 0; i < pcs->len[1]; i ++) {
+        for (j = 0; j < pcs->len[0]; j ++) {
+            if (pcs->str[0][j] == pcs->str[1][i]) {
+                row1[j + 1] = row0[j] + 1;
+            } else {
+                row1[j + 1] = ((row0[j + 1] > row1[j])?row0[j + 1]:row1[j]);
+            }
+        }
+        tmp = row0;
+        row0 = row1;
+        row1 = tmp;
+    }
+    ret = (int)(pcs->len[0] + pcs->len[1] - 2 * row0[pcs->len[0]]);
+    free (row0);
+    free (row1);
+    return ret;
+}
+
+/* the path is the same as the one of ed_edit_distance_path() */
+static int
+check_same_path (strcmp_t *cmpinfo, const char *path, size_t num)
+{
+    char *path0;
+    size_t num0;
+    int ret = -1;
+
+    num0 = cmpinfo->cb_len (cmpinfo->userdata_str, 0) + cmpinfo->cb_len (cmpinfo->userdata_str, 1);
+    path0 = (char *)malloc (num0 + 1);
+    if (NULL == path0) {
+        return -1;
+    }
+    if ((ed_edit_distance_path (cmpinfo, path0, &num0) >= 0) && (num0 == num) && (0 == memcmp (path0, path, num))) {
+        ret = 0;
+    }
+    free (path0);
+    return ret;
+}
+
+/* the lengths of the strings for check_path_engine(), the empty and one-sided-empty ones first */
+static const size_t g_check_lens[][2] = {
+    {0, 0}, {0, 9}, {11, 0}, {1, 1}, {1, 40}, {37, 2}, {63, 64}, {64, 65}, {130, 129}, {300, 280}, {1000, 990},
+};
+/* the similar strings: the length of the `left' string, the number of the edits to get the `right' one */
+static const size_t g_check_similar[][2] = {
+    {200, 0}, {200, 3}, {1000, 10}, {5000, 40},
+};
+static const int g_check_alphabets[] = {2, 4, 3000};
+
+#define CHECK_NUM_LENS    (sizeof (g_check_lens) / sizeof (g_check_lens[0]))
+#define CHECK_NUM_CASES   (CHECK_NUM_LENS + sizeof (g_check_similar) / sizeof (g_check_similar[0]))
+
+/* the `right' string is the `left' one after nedit random inserts, deletes or replaces */
+static int
+check_generate_similar (checkstr_t *pcs, size_t len, size_t nedit, int alphabet)
+{
+    size_t i;
+    size_t j;
+    size_t k;
+
+    if (check_generate (pcs, len, 0, alphabet) < 0) {
+        return -1;
+    }
+    free (pcs->str[1]);
+    pcs->str[1] = (wchar_t *)malloc (sizeof (wchar_t) * (len + nedit + 1));
+    if (NULL == pcs->str[1]) {
+        free (pcs->str[0]);
+        return -1;
+    }
+    memcpy (pcs->str[1], pcs->str[0], sizeof (wchar_t) * len);
+    j = len;
+    for (k = 0; k < nedit; k ++) {
+        i = ((j > 0)?(rand () % j):0);
+        switch (rand () % 3) {
+        case 0: /* insert */
+            memmove (pcs->str[1] + i + 1, pcs->str[1] + i, sizeof (wchar_t) * (j - i));
+            pcs->str[1][i] = 0x4E00 + rand () % alphabet;
+            j ++;
+            break;
+        case 1: /* delete */
+            if (j > 0) {
+                memmove (pcs->str[1] + i, pcs->str[1] + i + 1, sizeof (wchar_t) * (j - i - 1));
+                j --;
+            }
+            break;
+        default: /* replace */
+            if (j > 0) {
+                pcs->str[1][i] = 0x4E00 + rand () % alphabet;
+            }
+            break;
+        }
+    }
+    pcs->len[1] = j;
+    return 0;
+}
+
+/* the idx-th case of the strings, the random ones in g_check_lens[] first, then the similar ones in g_check_similar[] */
+static int
+check_generate_case (checkstr_t *pcs, size_t idx, int alphabet)
+{
+    if (idx < CHECK_NUM_LENS) {
+        return check_generate (pcs, g_check_lens[idx][0], g_check_lens[idx][1], alphabet);
+    }
+    idx -= CHECK_NUM_LENS;
+    return check_generate_similar (pcs, g_check_similar[idx][0], g_check_similar[idx][1], alphabet);
+}
+
+/* the distance of the engine agrees with ed_edit_distance() (check_indel_distance() for CHECK_INDEL), and its path replays against the strings */
+static int
+check_path_engine (const char *name, ed_path_cb_t cb_path, int flags)
+{
+    checkstr_t cstr;
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    strcmp_t cmpinfo;
+    char *path = NULL;
+    size_t num;
+    size_t i;
+    size_t a;
+    int d0;
+    int d1;
+    int cost;
+    int ret = 0;
+
+    mymat_init (&mat1);
+    mymat_init (&mat2);
+    for (i = 0; (0 == ret) && (i < CHECK_NUM_CASES); i ++) {
+        for (a = 0; (0 == ret) && (a < sizeof (g_check_alphabets) / sizeof (g_check_alphabets[0])); a ++) {
+            if (check_generate_case (&cstr, i, g_check_alphabets[a]) < 0) {
+                ret = -1;
+                break;
+            }
+            check_setup (&cmpinfo, &cstr, &mat1, &mat2);
+            /* the exact size, so any write out of it is caught by the address sanitizer */
+            num = cstr.len[0] + cstr.len[1];
+            path = (char *)malloc (num + ((0 == num)?1:0));
+            if (NULL == path) {
+                ret = -1;
+                check_free (&cstr);
+                break;
+            }
+            d0 = ((CHECK_INDEL & flags)?check_indel_distance (&cstr):ed_edit_distance (&cmpinfo));
+            d1 = cb_path (&cmpinfo, path, &num);
+            cost = ((d1 < 0)?-1:check_replay (&cstr, path, num));
+            if ((CHECK_INDEL & flags) && (cost >= 0) && (NULL != memchr (path, EDIS_REPLAC, num))) {
+                cost = -1;
+            }
+            if ((CHECK_SAME & flags) && (cost >= 0) && (check_same_path (&cmpinfo, path, num) < 0)) {
+                cost = -1;
+            }
+            if ((d0 < 0) || (d1 < 0) || (cost != d1)
+                || ((CHECK_UPPER & flags)?(d1 < d0):(d1 != d0))) {
+                fprintf (stderr, "%s: lena=%zu, lenb=%zu, alphabet=%d: distance %d vs %d, the path costs %d\n",
+                    name, cstr.len[0], cstr.len[1], g_check_alphabets[a], d0, d1, cost);
+                ret = -1;
+            }
+            free (path);
+            path = NULL;
+            check_free (&cstr);
+        }
+    }
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+/* the engine of the distance only, such as ed_edit_distance_bitpar() */
+typedef int (* check_dist_cb_t) (strcmp_t *cmpinfo);
+
+/* the distance of the engine is the same as ed_edit_distance() */
+static int
+check_dist_engine (const char *name, check_dist_cb_t cb_dist)
+{
+    checkstr_t cstr;
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    strcmp_t cmpinfo;
+    size_t i;
+    size_t a;
+    int d0;
+    int d1;
+    int ret = 0;
+
+    mymat_init (&mat1);
+    mymat_init (&mat2);
+    for (i = 0; (0 == ret) && (i < CHECK_NUM_CASES); i ++) {
+        for (a = 0; (0 == ret) && (a < sizeof (g_check_alphabets) / sizeof (g_check_alphabets[0])); a ++) {
+            if (check_generate_case (&cstr, i, g_check_alphabets[a]) < 0) {
+                ret = -1;
+                break;
+            }
+            check_setup (&cmpinfo, &cstr, &mat1, &mat2);
+            d0 = ed_edit_distance (&cmpinfo);
+            d1 = cb_dist (&cmpinfo);
+            if ((d0 < 0) || (d0 != d1)) {
+                fprintf (stderr, "%s: lena=%zu, lenb=%zu, alphabet=%d: distance %d vs %d\n",
+                    name, cstr.len[0], cstr.len[1], g_check_alphabets[a], d0, d1);
+                ret = -1;
+            }
+            check_free (&cstr);
+        }
+    }
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+/* the path of ed_edit_distance_path_simd() is the same as ed_edit_distance_path() byte for byte, for each instruction set */
+static int
+check_simd_path (void)
+{
+    static const size_t lens[][2] = {
+        {0, 0}, {0, 5}, {7, 0}, {1, 1}, {15, 17}, {16, 16}, {33, 31}, {100, 3}, {257, 250}, {600, 640},
+        /* longer than EDWAVE_MAX16, the values in 32 bits */
+        {32767, 20}, {24, 32767},
+    };
+    static const int alphabets[] = {2, 4, 3000};
+    static const int simds[] = {EDSIMD_SCALAR, EDSIMD_SSE41, EDSIMD_AVX2};
+    checkstr_t cstr;
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    strcmp_t cmpinfo;
+    char *path0 = NULL;
+    char *path1 = NULL;
+    size_t num0;
+    size_t num1;
+    size_t i;
+    size_t a;
+    size_t s;
+    int d0;
+    int d1;
+    int ret = 0;
+
+    mymat_init (&mat1);
+    mymat_init (&mat2);
+    for (i = 0; (0 == ret) && (i < sizeof (lens) / sizeof (lens[0])); i ++) {
+        for (a = 0; (0 == ret) && (a < sizeof (alphabets) / sizeof (alphabets[0])); a ++) {
+            if (check_generate (&cstr, lens[i][0], lens[i][1], alphabets[a]) < 0) {
+                ret = -1;
+                break;
+            }
+            check_setup (&cmpinfo, &cstr, &mat1, &mat2);
+            path0 = (char *)malloc (cstr.len[0] + cstr.len[1] + 1);
+            path1 = (char *)malloc (cstr.len[0] + cstr.len[1] + 1);
+            if ((NULL == path0) || (NULL == path1)) {
+                ret = -1;
+            }
+            num0 = cstr.len[0] + cstr.len[1];
+            d0 = ((0 == ret)?ed_edit_distance_path (&cmpinfo, path0, &num0):-1);
+            for (s = 0; (0 == ret) && (s < sizeof (simds) / sizeof (simds[0])); s ++) {
+                if (simds[s] > ed_simd_detect ()) {
+                    continue;
+                }
+                num1 = cstr.len[0] + cstr.len[1];
+                d1 = ed_edit_distance_path_simd (&cmpinfo, simds[s], path1, &num1);
+                if ((d0 < 0) || (d0 != d1) || (num0 != num1) || (0 != memcmp (path0, path1, num0))) {
+                    fprintf (stderr, "simd %d: lena=%zu, lenb=%zu, alphabet=%d: distance %d vs %d, path length %zu vs %zu\n",
+                        simds[s], cstr.len[0], cstr.len[1], alphabets[a], d0, d1, num0, num1);
+                    ret = -1;
+                }
+            }
+            /* no path, the distance only */
+            if ((0 == ret) && (d0 != ed_edit_distance_path_simd (&cmpinfo, EDSIMD_AUTO, NULL, NULL))) {
+                fprintf (stderr, "simd: lena=%zu, lenb=%zu: the distance without the path is not %d\n", cstr.len[0], cstr.len[1], d0);
+                ret = -1;
+            }
+            free (path0);
+            free (path1);
+            path0 = path1 = NULL;
+            check_free (&cstr);
+        }
+    }
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+/* the paths of the fills with the values in the delta mode (mymat_init_delta()) are the same as with the int */
+static int
+check_delta_path (void)
+{
+    static const size_t lens[][2] = {
+        {0, 3}, {1, 1}, {63, 64}, {64, 65}, {129, 127}, {300, 200}, {700, 650},
+    };
+    checkstr_t cstr;
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    mymatrix_t matd;
+    strcmp_t cmpinfo;
+    strcmp_t cmpdelta;
+    char *path0 = NULL;
+    char *path1 = NULL;
+    size_t num0;
+    size_t num1;
+    size_t i;
+    int algo;
+    int d0;
+    int d1;
+    int ret = 0;
+
+    mymat_init (&mat1);
+    mymat_init (&mat2);
+    mymat_init_delta (&matd);
+    for (i = 0; (0 == ret) && (i < sizeof (lens) / sizeof (lens[0])); i ++) {
+        if (check_generate (&cstr, lens[i][0], lens[i][1], 3) < 0) {
+            ret = -1;
+            break;
+        }
+        check_setup (&cmpinfo, &cstr, &mat1, &mat2);
+        cmpdelta = cmpinfo;
+        cmpdelta.userdata_matrix = &matd;
+        path0 = (char *)malloc (cstr.len[0] + cstr.len[1] + 1);
+        path1 = (char *)malloc (cstr.len[0] + cstr.len[1] + 1);
+        if ((NULL == path0) || (NULL == path1)) {
+            ret = -1;
+        }
+        /* 0 -- full, 1 -- recursive, 2 -- checkpoint */
+        for (algo = 0; (0 == ret) && (algo < 3); algo ++) {
+            num0 = num1 = cstr.len[0] + cstr.len[1];
+            switch (algo) {
+            case 0:
+                d0 = ed_edit_distance_path (&cmpinfo, path0, &num0);
+                d1 = ed_edit_distance_path (&cmpdelta, path1, &num1);
+                break;
+            case 1:
+                d0 = ed_edit_distance_path_recursive (&cmpinfo, path0, &num0);
+                d1 = ed_edit_distance_path_recursive (&cmpdelta, path1, &num1);
+                break;
+            default:
+                d0 = ed_edit_distance_path_checkpoint (&cmpinfo, 0, path0, &num0);
+                d1 = ed_edit_distance_path_checkpoint (&cmpdelta, 0, path1, &num1);
+                break;
+            }
+            if ((d0 < 0) || (d0 != d1) || (num0 != num1) || (0 != memcmp (path0, path1, num0))
+                || ((algo < 2) && (cstr.len[0] > 0) && (cstr.len[1] > 0) && (d0 != mymat_get (&matd, cstr.len[1], cstr.len[0])))) {
+                fprintf (stderr, "delta %d: lena=%zu, lenb=%zu: distance %d vs %d, path length %zu vs %zu\n",
+                    algo, cstr.len[0], cstr.len[1], d0, d1, num0, num1);
+                ret = -1;
+            }
+        }
+        free (path0);
+        free (path1);
+        path0 = path1 = NULL;
+        check_free (&cstr);
+    }
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    mymat_clear (&matd);
+    return ret;
+}
+
+/* the engine of the middle part fails, after it wrote the garbage to the path */
+static int
+check_path_fail (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    memset (path, EDIS_REPLAC, *ret_numpath);
+    return -1;
+}
+
+/* ed_edit_distance_path_trim() keeps in the buffer, and leaves the room of the suffix alone if the engine of the middle part fails */
+static int
+check_trim_path (void)
+{
+    static const size_t sizes[][3] = {
+        /* prefix, suffix, length of the middle */
+        {0, 0, 5}, {200, 200, 1}, {200, 200, 40}, {3, 250, 7}, {250, 0, 9},
+    };
+    static const ed_path_cb_t engines[] = {NULL, ed_edit_distance_path, check_path_fail};
+    checkstr_t cstr;
+    checkstr_t cmid;
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    strcmp_t cmpinfo;
+    strcmp_t cmpmid;
+    char *path = NULL;
+    size_t szbuf;
+    size_t num;
+    size_t pre;
+    size_t suf;
+    size_t i;
+    size_t e;
+    size_t k;
+    int d0;
+    int d1;
+    int ret = 0;
+
+    mymat_init (&mat1);
+    mymat_init (&mat2);
+    for (i = 0; (0 == ret) && (i < sizeof (sizes) / sizeof (sizes[0])); i ++) {
+        pre = sizes[i][0];
+        suf = sizes[i][1];
+        if (check_generate (&cstr, pre + sizes[i][2] + suf, pre + sizes[i][2] + 1 + suf, 4) < 0) {
+            ret = -1;
+            break;
+        }
+        /* the same prefix and suffix, the middle parts start and end by the different chars */
+        memcpy (cstr.str[1], cstr.str[0], sizeof (wchar_t) * pre);
+        memcpy (cstr.str[1] + cstr.len[1] - suf, cstr.str[0] + cstr.len[0] - suf, sizeof (wchar_t) * suf);
+        cstr.str[0][pre] = cstr.str[0][cstr.len[0] - suf - 1] = 0x4E00 + 4;
+        cstr.str[1][pre] = cstr.str[1][cstr.len[1] - suf - 1] = 0x4E00 + 5;
+        check_setup (&cmpinfo, &cstr, &mat1, &mat2);
+        cmid = cstr;
+        for (k = 0; k < 2; k ++) {
+            cmid.str[k] += pre;
+            cmid.len[k] -= pre + suf;
+        }
+        cmpmid = cmpinfo;
+        cmpmid.userdata_str = &cmid;
+        szbuf = cstr.len[0] + cstr.len[1];
+        /* the exact size, so any write out of it is caught by the address sanitizer */
+        path = (char *)malloc (szbuf);
+        if (NULL == path) {
+            ret = -1;
+        }
+        num = szbuf;
+        d0 = ((0 == ret)?ed_edit_distance_path (&cmpinfo, path, &num):-1);
+        for (e = 0; (0 == ret) && (e < sizeof (engines) / sizeof (engines[0])); e ++) {
+            memset (path, EDIS_NONE, szbuf);
+            num = szbuf;
+            d1 = ed_edit_distance_path_trim (&cmpmid, pre, suf, 0, engines[e], path, &num);
+            if (check_path_fail == engines[e]) {
+                for (k = szbuf - suf; (k < szbuf) && (EDIS_NONE == path[k]); k ++);
+                if ((-1 != d1) || (k < szbuf)) {
+                    fprintf (stderr, "trim: prefix=%zu, suffix=%zu: the failed engine returns %d, the path is changed at %zu\n", pre, suf, d1, k);
+                    ret = -1;
+                }
+                continue;
+            }
+            if ((d0 < 0) || (d0 != d1) || (num > szbuf)
+                || ((pre > 0) && (EDIS_IGNORE != path[0])) || ((suf > 0) && (EDIS_IGNORE != path[num - 1]))) {
+                fprintf (stderr, "trim %zu: prefix=%zu, suffix=%zu: distance %d vs %d, path length %zu\n", e, pre, suf, d0, d1, num);
+                ret = -1;
+            }
+        }
+        free (path);
+        path = NULL;
+        check_free (&cstr);
+    }
+    /* no room for the prefix and suffix */
+    if (0 == ret) {
+        char buf[4];
+        checkstr_t cempty = {{NULL, NULL}, {0, 0}};
+        cmpmid.userdata_str = &cempty;
+        num = sizeof (buf);
+        if (-1 != ed_edit_distance_path_trim (&cmpmid, 3, 2, 0, NULL, buf, &num)) {
+            fprintf (stderr, "trim: the short buffer is accepted\n");
+            ret = -1;
+        }
+    }
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+/* ed_edit_distance_batch() at the longest pairs of the 16-bit lanes, for each instruction set, against ed_edit_distance_bitpar() */
+static int
+check_batch_max (void)
+{
+    static const size_t lens[][3] = {
+        /* lena, lenb, alphabet; 0 -- no common chars, the distance is max(lena, lenb) */
+        {32766, 32766, 0}, {32766, 32765, 4}, {32767, 32767, 0}, {32766, 1, 0}, {1, 32766, 3}, {0, 32766, 0}, {300, 280, 0}, {5, 7, 2},
+    };
+    static const int simds[] = {EDSIMD_SCALAR, EDSIMD_SSE41, EDSIMD_AVX2};
+#define CHECK_BATCH_NUM (sizeof (lens) / sizeof (lens[0]))
+    checkstr_t cstr[CHECK_BATCH_NUM];
+    strcmp_t cmpinfo[CHECK_BATCH_NUM];
+    strcmp_t *pcmp[CHECK_BATCH_NUM];
+    int dist0[CHECK_BATCH_NUM];
+    int dist1[CHECK_BATCH_NUM];
+    size_t ngen;
+    size_t i;
+    size_t k;
+    size_t s;
+    int ret = 0;
+
+    for (ngen = 0; ngen < CHECK_BATCH_NUM; ngen ++) {
+        if (check_generate (&(cstr[ngen]), lens[ngen][0], lens[ngen][1], (lens[ngen][2] > 0)?lens[ngen][2]:4) < 0) {
+            ret = -1;
+            break;
+        }
+        if (0 == lens[ngen][2]) {
+            for (k = 0; k < cstr[ngen].len[1]; k ++) {
+                cstr[ngen].str[1][k] += 0x100;
+            }
+        }
+        check_setup (&(cmpinfo[ngen]), &(cstr[ngen]), NULL, NULL);
+        pcmp[ngen] = &(cmpinfo[ngen]);
+        dist0[ngen] = ed_edit_distance_bitpar (pcmp[ngen]);
+        if ((0 == lens[ngen][2]) && (dist0[ngen] != (int)((lens[ngen][0] > lens[ngen][1])?lens[ngen][0]:lens[ngen][1]))) {
+            fprintf (stderr, "batch: lena=%zu, lenb=%zu: the reference distance %d is wrong\n", lens[ngen][0], lens[ngen][1], dist0[ngen]);
+            ret = -1;
+        }
+    }
+    for (s = 0; (0 == ret) && (s < sizeof (simds) / sizeof (simds[0])); s ++) {
+        if (simds[s] > ed_simd_detect ()) {
+            continue;
+        }
+        memset (dist1, 0, sizeof (dist1));
+        if (ed_edit_distance_batch (pcmp, CHECK_BATCH_NUM, simds[s], dist1) < 0) {
+            fprintf (stderr, "batch simd %d: failed\n", simds[s]);
+            ret = -1;
+            break;
+        }
+        for (i = 0; i < CHECK_BATCH_NUM; i ++) {
+            if (dist0[i] != dist1[i]) {
+                fprintf (stderr, "batch simd %d: lena=%zu, lenb=%zu: distance %d vs %d\n", simds[s], lens[i][0], lens[i][1], dist0[i], dist1[i]);
+                ret = -1;
+            }
+        }
+    }
+    for (i = 0; i < ngen; i ++) {
+        check_free (&(cstr[i]));
+    }
+    return ret;
+#undef CHECK_BATCH_NUM
+}
+
+/* Hirschberg's linear space path */
+static int
+check_linear_path (void)
+{
+    return check_path_engine ("linear", ed_edit_distance_path_linear, CHECK_EXACT);
+}
+
+/* Myers' O(ND) path, the inserts and deletes only */
+static int
+check_myers_path (void)
+{
+    return check_path_engine ("myers", ed_edit_distance_path_myers, CHECK_INDEL);
+}
+
+/* the bit-parallel distance, across the 64-bit words */
+static int
+check_bitpar_dist (void)
+{
+    return check_dist_engine ("bitpar", ed_edit_distance_bitpar);
+}
+
+/* the path from the bit-parallel matrix */
+static int
+check_bitpar_path (void)
+{
+    return check_path_engine ("bitpar", ed_edit_distance_path_bitpar, CHECK_EXACT);
+}
+
+/* the banded distance and path, the band doubles until it covers the result */
+static int
+check_banded_dist (void)
+{
+    return check_dist_engine ("banded", ed_edit_distance_banded);
+}
+
+static int
+check_banded_path (void)
+{
+    return check_path_engine ("banded", ed_edit_distance_path_banded, CHECK_EXACT);
+}
+
+/* the path between the anchors; the anchors are kept as they are, so the distance may not be the minimal one */
+static int
+check_anchor_k0 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_anchor (cmpinfo, 0, NULL, path, ret_numpath);
+}
+
+static int
+check_anchor_k4 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_anchor (cmpinfo, 4, ed_edit_distance_path, path, ret_numpath);
+}
+
+static int
+check_anchor_k12 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_anchor (cmpinfo, 12, NULL, path, ret_numpath);
+}
+
+static int
+check_anchor_path (void)
+{
+    if (check_path_engine ("anchor 0", check_anchor_k0, CHECK_EXACT) < 0) {
+        return -1;
+    }
+    if (check_path_engine ("anchor 4", check_anchor_k4, CHECK_UPPER) < 0) {
+        return -1;
+    }
+    return check_path_engine ("anchor 12", check_anchor_k12, CHECK_UPPER);
+}
+
+/* Landau-Vishkin, the path by the diagonal transition */
+static int
+check_lv_path (void)
+{
+    return check_path_engine ("lv", ed_edit_distance_path_lv, CHECK_EXACT);
+}
+
+/* the bounded distance is the distance if it's within k, -1 otherwise, k around the distance */
+static int
+check_bounded_dist (void)
+{
+    checkstr_t cstr;
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    strcmp_t cmpinfo;
+    size_t i;
+    size_t a;
+    int ks[6];
+    int k;
+    int d0;
+    int d1;
+    int ret = 0;
+
+    mymat_init (&mat1);
+    mymat_init (&mat2);
+    for (i = 0; (0 == ret) && (i < CHECK_NUM_CASES); i ++) {
+        for (a = 0; (0 == ret) && (a < sizeof (g_check_alphabets) / sizeof (g_check_alphabets[0])); a ++) {
+            if (check_generate_case (&cstr, i, g_check_alphabets[a]) < 0) {
+                ret = -1;
+                break;
+            }
+            check_setup (&cmpinfo, &cstr, &mat1, &mat2);
+            d0 = ed_edit_distance (&cmpinfo);
+            ks[0] = 0;
+            ks[1] = d0 / 2;
+            ks[2] = d0 - 1;
+            ks[3] = d0;
+            ks[4] = d0 + 1;
+            ks[5] = d0 * 2 + 3;
+            for (k = 0; (0 == ret) && (k < (int)(sizeof (ks) / sizeof (ks[0]))); k ++) {
+                if (ks[k] < 0) {
+                    continue;
+                }
+                d1 = ed_edit_distance_bounded (&cmpinfo, ks[k]);
+                if ((d0 < 0) || (d1 != ((d0 <= ks[k])?d0:-1))) {
+                    fprintf (stderr, "bounded: lena=%zu, lenb=%zu, alphabet=%d: distance %d, k=%d returns %d\n",
+                        cstr.len[0], cstr.len[1], g_check_alphabets[a], d0, ks[k], d1);
+                    ret = -1;
+                }
+            }
+            check_free (&cstr);
+        }
+    }
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+/* the q-gram bound is between the length difference and the distance */
+static int
+check_qgram_bound (void)
+{
+    checkstr_t cstr;
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    strcmp_t cmpinfo;
+    size_t i;
+    size_t a;
+    size_t q;
+    int diff;
+    int d0;
+    int d1;
+    int ret = 0;
+
+    mymat_init (&mat1);
+    mymat_init (&mat2);
+    for (i = 0; (0 == ret) && (i < CHECK_NUM_CASES); i ++) {
+        for (a = 0; (0 == ret) && (a < sizeof (g_check_alphabets) / sizeof (g_check_alphabets[0])); a ++) {
+            if (check_generate_case (&cstr, i, g_check_alphabets[a]) < 0) {
+                ret = -1;
+                break;
+            }
+            check_setup (&cmpinfo, &cstr, &mat1, &mat2);
+            d0 = ed_edit_distance (&cmpinfo);
+            diff = (int)((cstr.len[0] > cstr.len[1])?(cstr.len[0] - cstr.len[1]):(cstr.len[1] - cstr.len[0]));
+            for (q = 1; (0 == ret) && (q <= 5); q ++) {
+                d1 = ed_qgram_lower_bound (&cmpinfo, q);
+                if ((d0 < 0) || (d1 < diff) || (d1 > d0)) {
+                    fprintf (stderr, "qgram: lena=%zu, lenb=%zu, alphabet=%d, q=%zu: the bound %d is out of [%d, %d]\n",
+                        cstr.len[0], cstr.len[1], g_check_alphabets[a], q, d1, diff, d0);
+                    ret = -1;
+                }
+            }
+            check_free (&cstr);
+        }
+    }
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+/* the blocked kernel of the Four Russians table, the same path as the full matrix */
+static int
+check_4r_dist (void)
+{
+    return check_dist_engine ("4r", ed_edit_distance_4r);
+}
+
+static int
+check_4r_path (void)
+{
+    return check_path_engine ("4r", ed_edit_distance_path_4r, CHECK_SAME);
+}
+
+/* the checkpoint rows every k rows, k = 0 for sqrt(rows) */
+static int
+check_ckpt_k0 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_checkpoint (cmpinfo, 0, path, ret_numpath);
+}
+
+static int
+check_ckpt_k1 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_checkpoint (cmpinfo, 1, path, ret_numpath);
+}
+
+static int
+check_ckpt_k7 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_checkpoint (cmpinfo, 7, path, ret_numpath);
+}
+
+static int
+check_ckpt_k5000 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_checkpoint (cmpinfo, 5000, path, ret_numpath);
+}
+
+static int
+check_checkpoint_path (void)
+{
+    if (check_path_engine ("checkpoint 0", check_ckpt_k0, CHECK_SAME) < 0) {
+        return -1;
+    }
+    if (check_path_engine ("checkpoint 1", check_ckpt_k1, CHECK_SAME) < 0) {
+        return -1;
+    }
+    if (check_path_engine ("checkpoint 7", check_ckpt_k7, CHECK_SAME) < 0) {
+        return -1;
+    }
+    return check_path_engine ("checkpoint 5000", check_ckpt_k5000, CHECK_SAME);
+}
+
+/* the recursive fill on the tiled matrices, as compcoll sets them up for '-a recursive' */
+static int
+check_recursive_tiled (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    strcmp_t cmptiled = *cmpinfo;
+    int ret;
+
+    mymat_init_delta (&mat1);
+    mymat_init_compact (&mat2);
+    mymat_set_nozero (&mat1, 1);
+    mymat_set_nozero (&mat2, 1);
+    mymat_set_tiled (&mat1, 1);
+    mymat_set_tiled (&mat2, 1);
+    cmptiled.userdata_matrix  = &mat1;
+    cmptiled.userdata_matrix2 = &mat2;
+    ret = ed_edit_distance_path_recursive (&cmptiled, path, ret_numpath);
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+static int
+check_recursive_path (void)
+{
+    if (check_path_engine ("recursive", ed_edit_distance_path_recursive, CHECK_SAME) < 0) {
+        return -1;
+    }
+    return check_path_engine ("recursive tiled", check_recursive_tiled, CHECK_SAME);
+}
+
+/* Hirschberg in nthreads threads, the path is the same as ed_edit_distance_path_linear(), or -1 */
+static int
+check_linear_mt (strcmp_t *cmpinfo, int nthreads, char *path, size_t *ret_numpath)
+{
+    char *path0;
+    size_t num0 = *ret_numpath;
+    int d0;
+    int d1;
+
+    path0 = (char *)malloc (num0 + 1);
+    if (NULL == path0) {
+        return -1;
+    }
+    d0 = ed_edit_distance_path_linear (cmpinfo, path0, &num0);
+    d1 = ed_edit_distance_path_linear_mt (cmpinfo, nthreads, path, ret_numpath);
+    if ((d0 != d1) || (num0 != *ret_numpath) || (0 != memcmp (path0, path, num0))) {
+        fprintf (stderr, "linear-mt %d: not the same path as linear\n", nthreads);
+        d1 = -1;
+    }
+    free (path0);
+    return d1;
+}
+
+static int
+check_linear_mt2 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return check_linear_mt (cmpinfo, 2, path, ret_numpath);
+}
+
+static int
+check_linear_mt5 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return check_linear_mt (cmpinfo, 5, path, ret_numpath);
+}
+
+static int
+check_linear_mt_path (void)
+{
+    if (check_path_engine ("linear-mt 2", check_linear_mt2, CHECK_EXACT) < 0) {
+        return -1;
+    }
+    return check_path_engine ("linear-mt 5", check_linear_mt5, CHECK_EXACT);
+}
+
+/* ed_edit_distance_batch() over several batches of the random lengths, the buffers are reused across the batches */
+static int
+check_batch_dist (void)
+{
+    static const int simds[] = {EDSIMD_SCALAR, EDSIMD_SSE41, EDSIMD_AVX2};
+#define CHECK_BATCH_NUM 53
+    checkstr_t cstr[CHECK_BATCH_NUM];
+    strcmp_t cmpinfo[CHECK_BATCH_NUM];
+    strcmp_t *pcmp[CHECK_BATCH_NUM];
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    int dist0[CHECK_BATCH_NUM];
+    int dist1[CHECK_BATCH_NUM];
+    size_t ngen;
+    size_t i;
+    size_t s;
+    int ret = 0;
+
+    mymat_init (&mat1);
+    mymat_init (&mat2);
+    for (ngen = 0; ngen < CHECK_BATCH_NUM; ngen ++) {
+        /* the empty ones, then the lengths up to 400 in the alphabets from 2 to 3000 */
+        if (check_generate (&(cstr[ngen]), (ngen < 2)?0:(rand () % 400), (1 == ngen)?0:(rand () % 400),
+                g_check_alphabets[ngen % (sizeof (g_check_alphabets) / sizeof (g_check_alphabets[0]))]) < 0) {
+            ret = -1;
+            break;
+        }
+        check_setup (&(cmpinfo[ngen]), &(cstr[ngen]), &mat1, &mat2);
+        pcmp[ngen] = &(cmpinfo[ngen]);
+        dist0[ngen] = ed_edit_distance (pcmp[ngen]);
+    }
+    for (s = 0; (0 == ret) && (s < sizeof (simds) / sizeof (simds[0])); s ++) {
+        if (simds[s] > ed_simd_detect ()) {
+            continue;
+        }
+        memset (dist1, 0, sizeof (dist1));
+        if (ed_edit_distance_batch (pcmp, CHECK_BATCH_NUM, simds[s], dist1) < 0) {
+            fprintf (stderr, "batch simd %d: failed\n", simds[s]);
+            ret = -1;
+            break;
+        }
+        for (i = 0; i < CHECK_BATCH_NUM; i ++) {
+            if (dist0[i] != dist1[i]) {
+                fprintf (stderr, "batch simd %d: lena=%zu, lenb=%zu: distance %d vs %d\n", simds[s], cstr[i].len[0], cstr[i].len[1], dist0[i], dist1[i]);
+                ret = -1;
+            }
+        }
+    }
+    for (i = 0; i < ngen; i ++) {
+        check_free (&(cstr[i]));
+    }
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+#undef CHECK_BATCH_NUM
+}
+
+/* the matrices of the values and the directions as compcoll sets them up for '-a full', the explicit huge pages asked for */
+static int
+check_full_hugetlb (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    strcmp_t cmpmat = *cmpinfo;
+    int ret;
+
+    mymat_init_delta (&mat1);
+    mymat_init_compact (&mat2);
+    mymat_set_nozero (&mat1, 1);
+    mymat_set_nozero (&mat2, 1);
+    mymat_set_hugetlb (&mat1, 1);
+    mymat_set_hugetlb (&mat2, 1);
+    cmpmat.userdata_matrix  = &mat1;
+    cmpmat.userdata_matrix2 = &mat2;
+    ret = ed_edit_distance_path (&cmpmat, path, ret_numpath);
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+/* the value of the cell in check_mmap_matrix(), the neighbours in a row differ by at most 1 for the delta mode */
+#define CHECK_MMAP_VAL(row, col) ((int)((row) % 100 + ((col) % 2)))
+
+/* the buffers of at least 4 MiB by mmap(): zero-filled unless nozero, cleared again when reused, and the values kept */
+static int
+check_mmap_matrix (void)
+{
+    /* the rows and the columns over 4 MiB for the int, the int8_t and the delta mode */
+    static const size_t sizes[] = {1100, 2100, 4100};
+    mymatrix_t mat;
+    size_t r;
+    size_t c;
+    size_t n;
+    int mode;
+    int nozero;
+    int huge;
+    int round;
+    int ret = 0;
+
+    for (mode = 0; (0 == ret) && (mode < 3); mode ++) {
+        for (nozero = 0; (0 == ret) && (nozero < 2); nozero ++) {
+            for (huge = 0; (0 == ret) && (huge < 2); huge ++) {
+                switch (mode) {
+                case 0: mymat_init (&mat); break;
+                case 1: mymat_init_compact (&mat); break;
+                default: mymat_init_delta (&mat); break;
+                }
+                mymat_set_nozero (&mat, nozero);
+                mymat_set_hugetlb (&mat, huge);
+                n = sizes[mode];
+                /* the first round maps a new buffer, the second one reuses it */
+                for (round = 0; (0 == ret) && (round < 2); round ++) {
+                    if ((mymat_resize (&mat, n, n) < 0) || (MYMAT_MAP_NONE == mat.flg_mmap)
+                        || ((! huge) && (MYMAT_MAP_HUGETLB == mat.flg_mmap))) {
+                        fprintf (stderr, "mmap: mode %d, nozero %d, hugetlb %d: %zux%zu is not mapped, or by the huge pages not asked for\n",
+                            mode, nozero, huge, n, n);
+                        ret = -1;
+                        break;
+                    }
+                    /* a cell of the delta mode is got by the ones on its left, so all are checked before any is set */
+                    for (r = 0; (0 == ret) && (! nozero) && (r < n); r ++) {
+                        for (c = 0; c < n; c ++) {
+                            if (0 != mymat_get (&mat, r, c)) {
+                                fprintf (stderr, "mmap: mode %d, hugetlb %d, round %d: (%zu, %zu) is not cleared\n", mode, huge, round, r, c);
+                                ret = -1;
+                                break;
+                            }
+                        }
+                    }
+                    for (r = 0; (0 == ret) && (r < n); r ++) {
+                        for (c = 0; c < n; c ++) {
+                            mymat_set (&mat, r, c, CHECK_MMAP_VAL (r, c));
+                        }
+                    }
+                    for (r = 0; (0 == ret) && (r < n); r ++) {
+                        for (c = 0; c < n; c ++) {
+                            if (CHECK_MMAP_VAL (r, c) != mymat_get (&mat, r, c)) {
+                                fprintf (stderr, "mmap: mode %d, nozero %d, hugetlb %d: (%zu, %zu) is %d\n",
+                                    mode, nozero, huge, r, c, mymat_get (&mat, r, c));
+                                ret = -1;
+                                break;
+                            }
+                        }
+                    }
+                }
+                mymat_clear (&mat);
+            }
+        }
+    }
+    if (0 == ret) {
+        ret = check_path_engine ("full hugetlb", check_full_hugetlb, CHECK_SAME);
+    }
+    return ret;
+}
+#undef CHECK_MMAP_VAL
+
+/* the directions in a scratch file, the values in the memory by the deltas, as compcoll sets them up for '-w' */
+static int
+check_scratch_run (strcmp_t *cmpinfo, ed_path_cb_t cb_path, char *path, size_t *ret_numpath)
+{
+    const char *dir = getenv ("TMPDIR");
+    mymatrix_t mat1;
+    mymatrix_t mat2;
+    strcmp_t cmpfile = *cmpinfo;
+    int ret;
+
+    mymat_init_delta (&mat1);
+    mymat_init_compact (&mat2);
+    mymat_set_nozero (&mat1, 1);
+    mymat_set_nozero (&mat2, 1);
+    mymat_set_file (&mat2, (NULL == dir)?"/tmp":dir);
+    mymat_set_tiled (&mat2, 1);
+    cmpfile.userdata_matrix  = &mat1;
+    cmpfile.userdata_matrix2 = &mat2;
+    ret = cb_path (&cmpfile, path, ret_numpath);
+    /* the full matrix of the directions of the pair of 5000 chars is 25 MB, it should be in the file */
+    if ((ed_edit_distance_path == cb_path) && (ret >= 0) && (mat2.szmem >= (4UL << 20)) && (MYMAT_MAP_FILE != mat2.flg_mmap)) {
+        fprintf (stderr, "scratch: the directions of %zu bytes are not in the file\n", mat2.szmem);
+        ret = -1;
+    }
+    mymat_clear (&mat1);
+    mymat_clear (&mat2);
+    return ret;
+}
+
+static int
+check_scratch_full (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return check_scratch_run (cmpinfo, ed_edit_distance_path, path, ret_numpath);
+}
+
+static int
+check_scratch_recursive (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return check_scratch_run (cmpinfo, ed_edit_distance_path_recursive, path, ret_numpath);
+}
+
+static int
+check_scratch_checkpoint (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return check_scratch_run (cmpinfo, check_ckpt_k0, path, ret_numpath);
+}
+
+/* the pairs of over 4M cells have the directions mapped from the file */
+static int
+check_scratch_path (void)
+{
+    if (check_path_engine ("scratch full", check_scratch_full, CHECK_SAME) < 0) {
+        return -1;
+    }
+    if (check_path_engine ("scratch recursive", check_scratch_recursive, CHECK_SAME) < 0) {
+        return -1;
+    }
+    return check_path_engine ("scratch checkpoint", check_scratch_checkpoint, CHECK_SAME);
+}
+
+/* the typed matrices as compcoll sets them up for '-a recursive' and '-a checkpoint': the narrowest values, 2-bit directions */
+static int
+check_edmat_run (strcmp_t *cmpinfo, ed_path_cb_t cb_path, int layout, char *path, size_t *ret_numpath)
+{
+    size_t lena = cmpinfo->cb_len (cmpinfo->userdata_str, 0);
+    size_t lenb = cmpinfo->cb_len (cmpinfo->userdata_str, 1);
+    strcmp_t cmpmat = *cmpinfo;
+    void *edm1;
+    void *edm2;
+    int ret = -1;
+
+    edm1 = edmat_create (edmat_type_fit (0, (lena > lenb)?lena:lenb), layout);
+    edm2 = edmat_create (EDMAT_BIT2, layout);
+    if ((NULL != edm1) && (NULL != edm2)) {
+        cmpmat.userdata_matrix  = edm1;
+        cmpmat.userdata_matrix2 = edm2;
+        cmpmat.cb_matget  = edmat_get;
+        cmpmat.cb_matset  = edmat_set;
+        cmpmat.cb_matresz = edmat_resize;
+        ret = cb_path (&cmpmat, path, ret_numpath);
+    }
+    edmat_destroy (edm1);
+    edmat_destroy (edm2);
+    return ret;
+}
+
+static int
+check_edmat_full (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return check_edmat_run (cmpinfo, ed_edit_distance_path, EDMAT_ROWS, path, ret_numpath);
+}
+
+static int
+check_edmat_recursive (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return check_edmat_run (cmpinfo, ed_edit_distance_path_recursive, EDMAT_TILED, path, ret_numpath);
+}
+
+static int
+check_edmat_checkpoint (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return check_edmat_run (cmpinfo, check_ckpt_k0, EDMAT_ROWS, path, ret_numpath);
+}
+
+/* the value of the cell in check_edmat_path(), in [lo, lo + range) */
+#define CHECK_EDMAT_VAL(row, col, lo, range) ((int)((lo) + (int)(((row) * 31 + (col) * 7) % (range))))
+
+/* each type and layout of edmat_*() keeps the values of its range across the resizes, and the paths on them are the same */
+static int
+check_edmat_path (void)
+{
+    static const int types[][3] = {
+        /* the type, the min and the max value */
+        {EDMAT_INT8, INT8_MIN, INT8_MAX}, {EDMAT_INT16, INT16_MIN, INT16_MAX}, {EDMAT_INT32, INT32_MIN, INT32_MAX},
+        {EDMAT_BIT1, 0, 1}, {EDMAT_BIT2, 0, 3}, {EDMAT_BIT4, 0, 15},
+    };
+    /* larger, smaller, then larger again: the buffer is reused without clearing */
+    static const size_t sizes[][2] = {
+        {37, 53}, {3, 2}, {100, 20}, {1, 1}, {129, 257},
+    };
+    void *edm;
+    size_t szbuf;
+    size_t r;
+    size_t c;
+    size_t t;
+    size_t i;
+    int range;
+    int layout;
+    int val;
+    int ret = 0;
+
+    for (t = 0; (0 == ret) && (t < sizeof (types) / sizeof (types[0])); t ++) {
+        if (types[t][0] != edmat_type_fit (types[t][1], types[t][2])) {
+            fprintf (stderr, "edmat: [%d, %d] is fit by %d, not %d\n", types[t][1], types[t][2],
+                edmat_type_fit (types[t][1], types[t][2]), types[t][0]);
+            ret = -1;
+            break;
+        }
+        /* the min and the max values, and the ones between */
+        range = (((int64_t)types[t][2] - types[t][1] < 1000)?(types[t][2] - types[t][1] + 1):1000);
+        for (layout = EDMAT_ROWS; (0 == ret) && (layout <= EDMAT_TILED); layout ++) {
+            edm = edmat_create (types[t][0], layout);
+            if (NULL == edm) {
+                ret = -1;
+                break;
+            }
+            for (i = 0; (0 == ret) && (i < sizeof (sizes) / sizeof (sizes[0])); i ++) {
+                if ((edmat_resize (edm, sizes[i][0], sizes[i][1]) < 0) || (NULL == edmat_buffer (edm, &szbuf))
+                    || (szbuf < edmat_memsize (edm) / 2)) {
+                    fprintf (stderr, "edmat: type %d, layout %d: resize to %zux%zu failed\n", types[t][0], layout, sizes[i][0], sizes[i][1]);
+                    ret = -1;
+                    break;
+                }
+                for (r = 0; r < sizes[i][0]; r ++) {
+                    for (c = 0; c < sizes[i][1]; c ++) {
+                        edmat_set (edm, r, c, CHECK_EDMAT_VAL (r, c, types[t][1], range));
+                    }
+                    edmat_set (edm, r, 0, types[t][1]);
+                    edmat_set (edm, r, sizes[i][1] - 1, types[t][2]);
+                }
+                for (r = 0; (0 == ret) && (r < sizes[i][0]); r ++) {
+                    for (c = 0; c < sizes[i][1]; c ++) {
+                        val = ((sizes[i][1] - 1 == c)?types[t][2]:((0 == c)?types[t][1]:CHECK_EDMAT_VAL (r, c, types[t][1], range)));
+                        if (val != edmat_get (edm, r, c)) {
+                            fprintf (stderr, "edmat: type %d, layout %d, %zux%zu: (%zu, %zu) is %d, not %d\n",
+                                types[t][0], layout, sizes[i][0], sizes[i][1], r, c, edmat_get (edm, r, c), val);
+                            ret = -1;
+                            break;
+                        }
+                    }
+                }
+            }
+            edmat_destroy (edm);
+        }
+    }
+    if (0 == ret) {
+        ret = check_path_engine ("edmat full", check_edmat_full, CHECK_SAME);
+    }
+    if (0 == ret) {
+        ret = check_path_engine ("edmat recursive", check_edmat_recursive, CHECK_SAME);
+    }
+    if (0 == ret) {
+        ret = check_path_engine ("edmat checkpoint", check_edmat_checkpoint, CHECK_SAME);
+    }
+    return ret;
+}
+#undef CHECK_EDMAT_VAL
+
+/* the tiled fill in 1 and 3 threads, the buffers by ed_numa_alloc() */
+static int
+check_tiled_t1 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_tiled (cmpinfo, 1, path, ret_numpath);
+}
+
+static int
+check_tiled_t3 (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    return ed_edit_distance_path_tiled (cmpinfo, 3, path, ret_numpath);
+}
+
+/* ed_numa_alloc() gives the zero-filled page-aligned buffers, and the threaded paths are the same pinned or not */
+static int
+check_numa_alloc (void)
+{
+    static const size_t lens[] = {1, 4095, 4096, 4097, (1 << 20) + 3};
+    static const int pins[] = {EDNUMA_PIN_OFF, EDNUMA_PIN_ON, EDNUMA_PIN_AUTO};
+    size_t pagesize = (size_t)sysconf (_SC_PAGESIZE);
+    char line[256];
+    FILE *fp;
+    char *buf;
+    size_t i;
+    size_t k;
+    size_t p;
+    int found;
+    int ret = 0;
+
+    for (p = 0; (0 == ret) && (p < sizeof (pins) / sizeof (pins[0])); p ++) {
+        ed_numa_set_pin (pins[p]);
+        for (i = 0; (0 == ret) && (i < sizeof (lens) / sizeof (lens[0])); i ++) {
+            buf = (char *)ed_numa_alloc (lens[i], 4);
+            if ((NULL == buf) || (0 != ((uintptr_t)buf % pagesize))) {
+                fprintf (stderr, "numa: pin %d: the buffer of %zu bytes is %p\n", pins[p], lens[i], buf);
+                ret = -1;
+                break;
+            }
+            for (k = 0; k < lens[i]; k ++) {
+                if (0 != buf[k]) {
+                    fprintf (stderr, "numa: pin %d: the buffer of %zu bytes is not zero at %zu\n", pins[p], lens[i], k);
+                    ret = -1;
+                    break;
+                }
+            }
+            memset (buf, 0x5A, lens[i]);
+            ed_numa_free (buf, lens[i]);
+        }
+        if (EDNUMA_PIN_AUTO == pins[p]) {
+            /* the same as EDNUMA_PIN_ON or EDNUMA_PIN_OFF, by the nodes of the allowed CPUs */
+            continue;
+        }
+        if (0 == ret) {
+            ret = check_path_engine ((EDNUMA_PIN_ON == pins[p])?"tiled 1 pinned":"tiled 1", check_tiled_t1, CHECK_SAME);
+        }
+        if (0 == ret) {
+            ret = check_path_engine ((EDNUMA_PIN_ON == pins[p])?"tiled 3 pinned":"tiled 3", check_tiled_t3, CHECK_SAME);
+        }
+        if ((0 == ret) && (EDNUMA_PIN_ON == pins[p])) {
+            /* linear-mt-path runs with EDNUMA_PIN_AUTO, not pinned on one node */
+            ret = check_path_engine ("linear-mt 5 pinned", check_linear_mt5, CHECK_EXACT);
+        }
+    }
+    ed_numa_set_pin (EDNUMA_PIN_AUTO);
+
+    /* the accounted buffer is in the report */
+    if (0 == ret) {
+        ret = -1;
+        ed_numa_set_report (1);
+        buf = (char *)ed_numa_alloc (lens[4], 1);
+        fp = tmpfile ();
+        if ((NULL != buf) && (NULL != fp)) {
+            memset (buf, 1, lens[4]);
+            ed_numa_account ("check buffer", buf, lens[4]);
+            ed_numa_report (fp);
+            rewind (fp);
+            for (found = 0; (! found) && (NULL != fgets (line, sizeof (line), fp)); ) {
+                found = (NULL != strstr (line, "check buffer"));
+            }
+            if (found) {
+                ret = 0;
+            } else {
+                fprintf (stderr, "numa: the accounted buffer is not in the report\n");
+            }
+        }
+        if (NULL != fp) {
+            fclose (fp);
+        }
+        if (NULL != buf) {
+            ed_numa_free (buf, lens[4]);
+        }
+        ed_numa_set_report (0);
+    }
+    return ret;
+}
+
+typedef int (* check_func_t) (void);
+
+typedef struct _check_item_t {
+    const char *name;
+    check_func_t func;
+} check_item_t;
+
+static check_item_t g_check_items[] = {
+    { "simd-path",   check_simd_path },
+    { "delta-path",  check_delta_path },
+    { "trim-path",   check_trim_path },
+    { "batch-max",   check_batch_max },
+    { "linear-path", check_linear_path },
+    { "myers-path",  check_myers_path },
+    { "bitpar-dist", check_bitpar_dist },
+    { "bitpar-path", check_bitpar_path },
+    { "banded-dist", check_banded_dist },
+    { "banded-path", check_banded_path },
+    { "anchor-path", check_anchor_path },
+    { "lv-path",     check_lv_path },
+    { "bounded-dist", check_bounded_dist },
+    { "qgram-bound", check_qgram_bound },
+    { "4r-dist",     check_4r_dist },
+    { "4r-path",     check_4r_path },
+    { "checkpoint-path", check_checkpoint_path },
+    { "recursive-path", check_recursive_path },
+    { "linear-mt-path", check_linear_mt_path },
+    { "batch-dist",  check_batch_dist },
+    { "mmap-matrix", check_mmap_matrix },
+    { "scratch-path", check_scratch_path },
+    { "edmat-path",  check_edmat_path },
+    { "numa-alloc",  check_numa_alloc },
+};
+
+#define NUM_ITEMS(a) (sizeof(a)/sizeof(a[0]))
+
+int
+main (int argc, char * argv[])
+{
+    size_t i;
+    int c;
+    int ret = 0;
+
+    srand (1);
+    for (i = 0; i < NUM_ITEMS(g_check_items); i ++) {
+        if (argc > 1) {
+            for (c = 1; c < argc; c ++) {
+                if (0 == strcmp (argv[c], g_check_items[i].name)) {
+                    break;
+                }
+            }
+            if (c >= argc) {
+                continue;
+            }
+        }
+        if (g_check_items[i].func () < 0) {
+            printf ("FAIL: %s\n", g_check_items[i].name);
+            ret = 1;
+            continue;
+        }
+        printf ("PASS: %s\n", g_check_items[i].name);
+    }
+    return ret;
+}
@@ -7,10 +7,15 @@
  * @date    2016-03-13
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h> /* sysconf() */
+#include <pthread.h>
 
 #include "editdistance.h"
+#include "edkernel.h"
+#include "ednuma.h"
 
 #define MIN(a,b) (((a)<(b))?(a):(b))
 
@@ -109,17 +114,6 @@ $$
 int
 ed_edit_distance (strcmp_t *cmpinfo)
 {
-    //static int *g_matrix = NULL;
-    //static int g_num_matrix = 0;
-
-    int i;
-    int j;
-
-    int pi; /* Pinsert */
-    int pd; /* Pdelete */
-    int pr; /* Pignore/Preplace */
-    int crossval; /* 斜临的值 */
-
     assert (NULL != cmpinfo);
     assert (NULL != cmpinfo->cb_comp);
     assert (NULL != cmpinfo->cb_len);
@@ -131,114 +125,8 @@ ed_edit_distance (strcmp_t *cmpinfo)
     assert (NULL != cmpinfo->cb_getval);
 #endif
 
-    // 如果有一个字符串的长度为0,则直接返回值
-    if (cmpinfo->cb_len(cmpinfo->userdata_str, 0) < 1) {
-        return cmpinfo->cb_len(cmpinfo->userdata_str, 1);
-    }
-    if (cmpinfo->cb_len(cmpinfo->userdata_str, 1) < 1) {
-        return cmpinfo->cb_len(cmpinfo->userdata_str, 0);
-    }
-//#if ! DEBUG
-    ///* swap the array with minmal number of items to the vertical line */
-    //if (lena > lenb) {
-        //char * tmp = (char *)stra;
-        //stra = strb;
-        //strb = tmp;
-        //i = lena;
-        //lena = lenb;
-        //lenb = i;
-    //}
-//#endif
-
-    // 设置行缓冲
-    cmpinfo->cb_matresz (cmpinfo->userdata_matrix, 1, cmpinfo->cb_len(cmpinfo->userdata_str, 0) + 1);
-
-#if USE_OUT_ED_TABLE
-    // 用于记录操作, 只做显示用
-    char action = EDIS_NONE;
-    cmpinfo->cb_matresz (cmpinfo->userdata_matrix2, 1, cmpinfo->cb_len(cmpinfo->userdata_str, 0) + 1);
-
-    TRACE ("    |    |");
-    for (i = 0; i < cmpinfo->cb_len(cmpinfo->userdata_str, 0); i ++) {
-        TRACE (" ");
-        cmpinfo->cb_output (cmpinfo->userdata_str, stderr, 0, i);
-        TRACE (" |");
-    }
-    TRACE ("\n");
-    TRACE ("    |");
-#endif
-    for (i = 0; i <= cmpinfo->cb_len(cmpinfo->userdata_str, 0); i ++) {
-        cmpinfo->cb_matset (cmpinfo->userdata_matrix, 0, i, i);
-#if USE_OUT_ED_TABLE
-        TRACE (" %2d |", i);
-#endif
-    }
-#if USE_OUT_ED_TABLE
-    TRACE ("\n");
-#endif
-    for (i = 1; i <= cmpinfo->cb_len(cmpinfo->userdata_str, 1); i ++) {
-        crossval = i - 1;
-#if USE_OUT_ED_TABLE
-        TRACE (" ");
-        cmpinfo->cb_output (cmpinfo->userdata_str, stderr, 1, i-1);
-        TRACE (" |");
-        TRACE (" %2d |", i);
-#endif
-        for (j = 1; j <= cmpinfo->cb_len(cmpinfo->userdata_str, 0); j ++) {
-#if USE_OUT_ED_TABLE
-            action = EDIS_NONE;
-#endif
-            /* matrix[i-1][j] + 1 */
-            pi = 1 + cmpinfo->cb_matget (cmpinfo->userdata_matrix, 0, j); /* 之前的一行刷新后不再需要了，所以可以重复使用这行的缓冲 */
-
-            /* matrix[i][j-1] + 1 */
-            if (j == 1) {
-                pd = i + 1; /* 因为在这0列上的值是固定的 */
-            } else {
-                //pd = g_matrix[j - 1] + 1;
-                pd = 1 + cmpinfo->cb_matget (cmpinfo->userdata_matrix, 0, j - 1);
-            }
-
-            /* matrix[i-1][j-1] + (B[i-1]!=A[j-1]) */
-            //pr = crossval + (strb[i - 1] == stra[j - 1]?0:1);
-            pr = crossval + ((0 == cmpinfo->cb_comp(cmpinfo->userdata_str, j - 1, i - 1))?0:1);
-
-#if USE_OUT_ED_TABLE
-            if (pi > pd) {
-                action = EDIS_DELETE;
-            } else {
-                action = EDIS_INSERT;
-            }
-#endif
-            pi = MIN (pi, pd);
-
-#if USE_OUT_ED_TABLE
-            if (pi > pr) {
-                action = EDIS_REPLAC;
-            }
-#endif
-            //crossval = g_matrix[j];
-            crossval = cmpinfo->cb_matget (cmpinfo->userdata_matrix, 0, j);  /* crossval 存储左上角的数据值，因为前一行的数据将被冲掉，该值是唯一需要保存的 */
-            //g_matrix[j] = MIN (pi, pr);
-            cmpinfo->cb_matset (cmpinfo->userdata_matrix, 0, j, MIN (pi, pr));
-#if USE_OUT_ED_TABLE
-            cmpinfo->cb_matset (cmpinfo->userdata_matrix2, 0, j, action);
-            TRACE (" %2d |", cmpinfo->cb_matget (cmpinfo->userdata_matrix, 0, j));
-#endif
-        }
-#if USE_OUT_ED_TABLE
-        TRACE ("\n");
-        TRACE ("----|----|");
-        for (j = 1; j <= cmpinfo->cb_len(cmpinfo->userdata_str, 0); j ++) {
-            TRACE ("^ ");
-            TRACE ("%s", edaction_val2cstr (cmpinfo->cb_matget (cmpinfo->userdata_matrix2, 0, j)));
-            TRACE ("^|");
-        }
-        TRACE ("\n");
-#endif
-    }
-    //return g_matrix[cmpinfo->cb_len(cmpinfo->userdata_str, 0)];
-    return cmpinfo->cb_matget (cmpinfo->userdata_matrix, 0, cmpinfo->cb_len(cmpinfo->userdata_str, 0) );
+    /* the kernel is instantiated in edkernel.cpp, with the matrix accessed directly if it's a mymatrix_t */
+    return ed_kernel_distance_cb (cmpinfo);
 }
 
 /**
@@ -269,12 +157,9 @@ ed_edit_distance_path (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
     //static int g_num_matrix = 0;
 
     int i;
+#if USE_OUT_ED_TABLE
     int j;
-
-    int pi; /* Pinsert */
-    int pd; /* Pdelete */
-    int pr; /* Pignore/Preplace */
-    char flg_equ;
+#endif
     int lena;
     int lenb;
 
@@ -291,89 +176,19 @@ ed_edit_distance_path (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
         for (i = 0; i < lenb; i ++) {
             path[i] = EDIS_INSERT;
         }
+        *ret_numpath = lenb;
         return lenb;
     }
     if (lenb < 1) {
         for (i = 0; i < lena; i ++) {
-            path[i] = EDIS_INSERT;
+            path[i] = EDIS_DELETE;
         }
+        *ret_numpath = lena;
         return lena;
     }
 
-    // 设置缓冲
-    cmpinfo->cb_matresz (cmpinfo->userdata_matrix, lenb + 1, lena + 1);
-    cmpinfo->cb_matresz (cmpinfo->userdata_matrix2, lenb + 1, lena + 1);
-
-    for (i = 0; i <= lena; i ++) {
-        /*g_matrix_val[0][i] = i; */
-        /*g_matrix_dir[0][i] = EDIS_INSERT; */
-        cmpinfo->cb_matset (cmpinfo->userdata_matrix,  0, i, i);
-        cmpinfo->cb_matset (cmpinfo->userdata_matrix2, 0, i, EDIS_DELETE);
-    }
-    for (i = 0; i <= lenb; i ++) {
-        //g_matrix_val[i* (lena + 1)] = i;
-        //g_matrix_dir[i* (lena + 1)] = EDIS_INSERT;
-        cmpinfo->cb_matset (cmpinfo->userdata_matrix,  i, 0, i);
-        cmpinfo->cb_matset (cmpinfo->userdata_matrix2, i, 0, EDIS_INSERT);
-    }
-    /*g_matrix_dir[0][0] = EDIS_NONE; */
-    cmpinfo->cb_matset (cmpinfo->userdata_matrix2, 0, 0, EDIS_NONE);
-    for (i = 1; i <= lenb; i ++) {
-        for (j = 1; j <= lena; j ++) {
-            /*pi = g_matrix_val[i - 1][j] + 1; */
-            /*pd = g_matrix_val[i][j - 1] + 1; */
-            /*pr = g_matrix_val[i - 1][j - 1] + (strb[i - 1] == stra[j - 1]?0:1); */
-            pi = 1 + cmpinfo->cb_matget (cmpinfo->userdata_matrix,  i - 1, j);
-            pd = 1 + cmpinfo->cb_matget (cmpinfo->userdata_matrix,  i, j - 1);
-            flg_equ = (0 == cmpinfo->cb_comp(cmpinfo->userdata_str, j - 1, i - 1));
-            pr = cmpinfo->cb_matget (cmpinfo->userdata_matrix,  i - 1, j - 1) + (flg_equ?0:1);
-            if (pi < pd) {
-                if (pr < pi) {
-                    /* pr < pi < pd */
-                    //g_matrix_val[i * (lena + 1) + j] = pr;
-                    cmpinfo->cb_matset (cmpinfo->userdata_matrix, i, j, pr);
-                    if (flg_equ) {
-                        //g_matrix_dir[i * (lena + 1) + j] = EDIS_IGNORE;
-                        cmpinfo->cb_matset (cmpinfo->userdata_matrix2, i, j, EDIS_IGNORE);
-                    } else {
-                        //g_matrix_dir[i * (lena + 1) + j] = EDIS_REPLAC;
-                        cmpinfo->cb_matset (cmpinfo->userdata_matrix2, i, j, EDIS_REPLAC);
-                    }
-                } else { /* pr >= pi */
-                    //g_matrix_val[i][j] = pi;
-                    //g_matrix_dir[i][j] = EDIS_INSERT;
-                    cmpinfo->cb_matset (cmpinfo->userdata_matrix, i, j, pi);
-                    cmpinfo->cb_matset (cmpinfo->userdata_matrix2, i, j, EDIS_INSERT);
-                }
-            } else { /* pi >= pd */
-                if (pr < pi) {
-                    if (pd < pr) {
-                        /* pd < pr < pi */
-                        //g_matrix_val[i * (lena + 1) + j] = pd;
-                        //g_matrix_dir[i * (lena + 1) + j] = EDIS_DELETE;
-                        cmpinfo->cb_matset (cmpinfo->userdata_matrix, i, j, pd);
-                        cmpinfo->cb_matset (cmpinfo->userdata_matrix2, i, j, EDIS_DELETE);
-                    } else { /* pd >= pr */
-                        /* pr <= pd <= pi */
-                        //g_matrix_val[i * (lena + 1) + j] = pr;
-                        cmpinfo->cb_matset (cmpinfo->userdata_matrix, i, j, pr);
-                        if (flg_equ) {
-                            //g_matrix_dir[i * (lena + 1) + j] = EDIS_IGNORE;
-                            cmpinfo->cb_matset (cmpinfo->userdata_matrix2, i, j, EDIS_IGNORE);
-                        } else {
-                            //g_matrix_dir[i * (lena + 1) + j] = EDIS_REPLAC;
-                            cmpinfo->cb_matset (cmpinfo->userdata_matrix2, i, j, EDIS_REPLAC);
-                        }
-                    }
-                } else { /* pi <= pr */
-                    /* pd <= pi <= pr */
-                    //g_matrix_val[i * (lena + 1) + j] = pd;
-                    //g_matrix_dir[i * (lena + 1) + j] = EDIS_DELETE;
-                    cmpinfo->cb_matset (cmpinfo->userdata_matrix, i, j, pd);
-                    cmpinfo->cb_matset (cmpinfo->userdata_matrix2, i, j, EDIS_DELETE);
-                }
-            }
-        }
+    if (ed_kernel_path_fill_cb (cmpinfo) < 0) {
+        return -1;
     }
 #if USE_OUT_ED_TABLE
     TRACE ("----|----|");
@@ -416,52 +231,7 @@ ed_edit_distance_path (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
         TRACE ("\n");
     }
 #endif
-    i = lenb;
-    j = lena;
-    assert (i > 0);
-    assert (j > 0);
-    for (pi = lena + lenb; pi > 0; pi --) {
-        if (i < 0 || j < 0) {
-            DBGMSG (PFDBG_CATLOG_PF, PFDBG_LEVEL_ERROR, "Implementation bug!!");
-            DBGMSG (PFDBG_CATLOG_PF, PFDBG_LEVEL_ERROR, "The i,j overflow: lena(%d)+lenb(%d)=(%d), pi(%d), pi(%d), pi(%d)", lena, lenb, lena + lenb, pi, i, j);
-            assert (pi >= 0);
-            assert (i >= 0);
-            assert (j >= 0);
-            assert (0);
-            break;
-        }
-        if (EDIS_NONE == cmpinfo->cb_matget (cmpinfo->userdata_matrix2, i, j) ) {
-            break;
-        }
-        path[pi - 1] = cmpinfo->cb_matget (cmpinfo->userdata_matrix2, i, j);
-#if USE_OUT_ED_TABLE
-        TRACE ("path[%d]: %s, (i,j) from (%d,%d)", pi, edaction_val2cstr(path[pi - 1]), i, j);
-#endif
-        switch (path[pi - 1]) {
-        case EDIS_INSERT:
-            i --;
-            break;
-        case EDIS_DELETE:
-            j --;
-            break;
-        case EDIS_REPLAC:
-        case EDIS_IGNORE:
-            i --;
-            j --;
-            break;
-        case EDIS_NONE:
-        default:
-            assert (0);
-            break;
-        }
-#if USE_OUT_ED_TABLE
-        TRACE ("to (%d,%d)\n", i, j);
-#endif
-    }
-    if (pi > 0) {
-        memmove (path, &(path[pi]), sizeof (char) * (lena + lenb - pi));
-    }
-    *ret_numpath = lena + lenb - pi;
+    *ret_numpath = ed_kernel_path_traceback_cb (cmpinfo, path);
 #if USE_OUT_ED_TABLE
     assert (NULL != path);
     //printf ("convert from string 1: %s\nTO %s\n", stra, strb);
@@ -474,3 +244,769 @@ ed_edit_distance_path (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
 #endif
     return cmpinfo->cb_matget (cmpinfo->userdata_matrix, lenb, lena);
 }
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, 按递归的顺序填充矩阵
+ *
+ * @param cmpinfo : 字符串的访问接口
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 内存不足时返回 -1
+ *
+ * 结果和 ed_edit_distance_path() 完全相同(包括路径)，使用同样的 cb_mat* 矩阵，只是填充的顺序不同:
+ * 矩阵被递归地分成两半直到 256x256 的小块，小块的数据总能放进缓存，行宽超过缓存时比逐行填充快。
+ * 矩阵是 mymatrix_t 时可以用 mymat_set_tiled() 按块存储，使小块在内存中也是连续的。
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_recursive (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    int lena;
+    int lenb;
+
+    if (NULL == path) {
+        return ed_edit_distance (cmpinfo);
+    }
+    assert (NULL != ret_numpath);
+    lena = cmpinfo->cb_len(cmpinfo->userdata_str, 0);
+    lenb = cmpinfo->cb_len(cmpinfo->userdata_str, 1);
+    if ((lena < 1) || (lenb < 1)) {
+        return ed_edit_distance_path (cmpinfo, path, ret_numpath);
+    }
+    if (ed_kernel_path_fill_recursive_cb (cmpinfo) < 0) {
+        return -1;
+    }
+    *ret_numpath = ed_kernel_path_traceback_cb (cmpinfo, path);
+    return cmpinfo->cb_matget (cmpinfo->userdata_matrix, lenb, lena);
+}
+
+/**
+ * @brief 把一个字符串通过 cb_getval 接口复制到新分配的缓冲中
+ *
+ * @param cmpinfo : 字符串的访问接口
+ * @param right : 0 -- `left' string, 1 -- `right' string
+ * @param ret_len : 返回字符串的长度
+ *
+ * @return 返回缓冲(需要调用者 free), 失败返回 NULL
+ *
+ * 以下那些不需要逐个调用 cb_comp 的算法使用这个函数，字符相等的判断就是 wchar_t 值相等。
+ */
+wchar_t *
+ed_fetch_string (strcmp_t *cmpinfo, int right, size_t *ret_len)
+{
+    wchar_t *buf;
+    size_t len;
+    size_t i;
+
+    assert (NULL != cmpinfo);
+    assert (NULL != cmpinfo->cb_len);
+    assert (NULL != cmpinfo->cb_getval);
+    assert (NULL != ret_len);
+    len = cmpinfo->cb_len(cmpinfo->userdata_str, right);
+    buf = (wchar_t *)malloc (sizeof (wchar_t) * (len + 1));
+    if (NULL == buf) {
+        return NULL;
+    }
+    for (i = 0; i < len; i ++) {
+        buf[i] = cmpinfo->cb_getval (cmpinfo->userdata_str, right, i);
+    }
+    buf[len] = 0;
+    *ret_len = len;
+    return buf;
+}
+
+#define ED_CMPBLOCK 64 /* the number of wchar_t compared by one memcmp() */
+
+/**
+ * @brief 两个字符串相同的前缀的长度
+ *
+ * @param stra : 第1个字符串
+ * @param strb : 第2个字符串
+ * @param len : 两个字符串中较短的长度
+ *
+ * @return 返回相同前缀的长度
+ *
+ * 先用 memcmp() 逐块比较(libc 中的 memcmp 是向量化的), 再在不同的块中逐个比较
+ */
+size_t
+ed_common_prefix (const wchar_t *stra, const wchar_t *strb, size_t len)
+{
+    size_t i = 0;
+    while ((i + ED_CMPBLOCK <= len) && (0 == memcmp (stra + i, strb + i, sizeof (wchar_t) * ED_CMPBLOCK))) {
+        i += ED_CMPBLOCK;
+    }
+    while ((i < len) && (stra[i] == strb[i])) {
+        i ++;
+    }
+    return i;
+}
+
+/**
+ * @brief 两个字符串相同的后缀的长度
+ *
+ * @param stra : 第1个字符串
+ * @param lena : 第1个字符串的长度
+ * @param strb : 第2个字符串
+ * @param lenb : 第2个字符串的长度
+ *
+ * @return 返回相同后缀的长度
+ */
+size_t
+ed_common_suffix (const wchar_t *stra, size_t lena, const wchar_t *strb, size_t lenb)
+{
+    size_t len = MIN (lena, lenb);
+    size_t i = 0;
+    while ((i + ED_CMPBLOCK <= len) && (0 == memcmp (stra + lena - i - ED_CMPBLOCK, strb + lenb - i - ED_CMPBLOCK, sizeof (wchar_t) * ED_CMPBLOCK))) {
+        i += ED_CMPBLOCK;
+    }
+    while ((i < len) && (stra[lena - i - 1] == strb[lenb - i - 1])) {
+        i ++;
+    }
+    return i;
+}
+
+/**********************************************************************************/
+/* Hirschberg: 线性空间的编辑路径 */
+
+/* 计算 b[b0..b1) 对 a[a0..a0+j) 的距离, 结果存入 row[0..a1-a0] */
+static void
+ed_lin_row_forward (strcmp_t *cmpinfo, size_t a0, size_t a1, size_t b0, size_t b1, int *row)
+{
+    size_t i;
+    size_t j;
+    size_t n = a1 - a0;
+    int diag;
+    int tmp;
+    int val;
+
+    for (j = 0; j <= n; j ++) {
+        row[j] = j;
+    }
+    for (i = b0; i < b1; i ++) {
+        diag = row[0];
+        row[0] = i - b0 + 1;
+        for (j = 1; j <= n; j ++) {
+            tmp = row[j];
+            val = diag + ((0 == cmpinfo->cb_comp(cmpinfo->userdata_str, a0 + j - 1, i))?0:1);
+            val = MIN (val, row[j] + 1);
+            val = MIN (val, row[j - 1] + 1);
+            row[j] = val;
+            diag = tmp;
+        }
+    }
+}
+
+/* 计算 b[b0..b1) 对 a[a0+j..a1) 的距离, 结果存入 row[0..a1-a0] */
+static void
+ed_lin_row_reverse (strcmp_t *cmpinfo, size_t a0, size_t a1, size_t b0, size_t b1, int *row)
+{
+    size_t i;
+    size_t j;
+    size_t n = a1 - a0;
+    int diag;
+    int tmp;
+    int val;
+
+    for (j = 0; j <= n; j ++) {
+        row[j] = n - j;
+    }
+    for (i = b1; i > b0; i --) {
+        diag = row[n];
+        row[n] = b1 - i + 1;
+        for (j = n; j > 0; j --) {
+            tmp = row[j - 1];
+            val = diag + ((0 == cmpinfo->cb_comp(cmpinfo->userdata_str, a0 + j - 1, i - 1))?0:1);
+            val = MIN (val, row[j - 1] + 1);
+            val = MIN (val, row[j] + 1);
+            row[j - 1] = val;
+            diag = tmp;
+        }
+    }
+}
+
+typedef struct _ed_linear_t {
+    strcmp_t *cmpinfo;
+    int *rowf;      /* forward row, lena + 1 items */
+    int *rowr;      /* reverse row, lena + 1 items */
+    char *path;
+    size_t numpath; /* the number of items filled in path */
+    int dist;
+} ed_linear_t;
+
+static void
+ed_lin_append (ed_linear_t *pl, char action, size_t num)
+{
+    for (; num > 0; num --) {
+        pl->path[pl->numpath ++] = action;
+        if (EDIS_IGNORE != action) {
+            pl->dist ++;
+        }
+    }
+}
+
+/* 对 a[a0..a1) 和 b[b0..b1) 做分治 */
+static void
+ed_lin_recursive (ed_linear_t *pl, size_t a0, size_t a1, size_t b0, size_t b1)
+{
+    size_t j;
+    size_t jmin;
+    size_t bmid;
+    int val;
+    int valmin;
+
+    if (b0 >= b1) {
+        ed_lin_append (pl, EDIS_DELETE, a1 - a0);
+        return;
+    }
+    if (a0 >= a1) {
+        ed_lin_append (pl, EDIS_INSERT, b1 - b0);
+        return;
+    }
+    if (b0 + 1 == b1) {
+        /* 只剩一个字符: 找到第一个相同字符对齐, 否则替换第一个字符 */
+        for (j = a0; j < a1; j ++) {
+            if (0 == pl->cmpinfo->cb_comp(pl->cmpinfo->userdata_str, j, b0)) {
+                break;
+            }
+        }
+        if (j < a1) {
+            ed_lin_append (pl, EDIS_DELETE, j - a0);
+            ed_lin_append (pl, EDIS_IGNORE, 1);
+            ed_lin_append (pl, EDIS_DELETE, a1 - j - 1);
+        } else {
+            ed_lin_append (pl, EDIS_REPLAC, 1);
+            ed_lin_append (pl, EDIS_DELETE, a1 - a0 - 1);
+        }
+        return;
+    }
+
+    bmid = b0 + (b1 - b0) / 2;
+    ed_lin_row_forward (pl->cmpinfo, a0, a1, b0, bmid, pl->rowf);
+    ed_lin_row_reverse (pl->cmpinfo, a0, a1, bmid, b1, pl->rowr);
+    jmin = 0;
+    valmin = pl->rowf[0] + pl->rowr[0];
+    for (j = 1; j <= a1 - a0; j ++) {
+        val = pl->rowf[j] + pl->rowr[j];
+        if (val < valmin) {
+            valmin = val;
+            jmin = j;
+        }
+    }
+    /* 两个缓冲在递归前已经用完，所以子问题可以重复使用 */
+    ed_lin_recursive (pl, a0, a0 + jmin, b0, bmid);
+    ed_lin_recursive (pl, a0 + jmin, a1, bmid, b1);
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, 线性空间版本
+ *
+ * @param cmpinfo : 字符串的访问接口
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 内存不足时返回 -1
+ *
+ * 本函数用 Hirschberg 分治算法返回和 ed_edit_distance_path() 一样的最优距离值和修改路径(路径的选择可能不同)。
+ * 时间O(m*n)(约为后者的两倍), 空间O(m+n)，不需要 cb_mat* 接口所用的矩阵。
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ *
+ * 以 b 的中间一行为界, 正向计算上半部分最后一行，反向计算下半部分第一行，
+ * 两行对应值之和最小的列就是最优路径穿过中间行的位置，然后对左上、右下两个子矩阵递归处理。
+ */
+int
+ed_edit_distance_path_linear (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    ed_linear_t lin;
+    int lena;
+    int lenb;
+
+    assert (NULL != cmpinfo);
+    assert (NULL != cmpinfo->cb_comp);
+    assert (NULL != cmpinfo->cb_len);
+    if (NULL == path) {
+        return ed_edit_distance (cmpinfo);
+    }
+    assert (NULL != ret_numpath);
+    lena = cmpinfo->cb_len(cmpinfo->userdata_str, 0);
+    lenb = cmpinfo->cb_len(cmpinfo->userdata_str, 1);
+    assert (lena >= 0);
+    assert (lenb >= 0);
+
+    memset (&lin, 0, sizeof (lin));
+    lin.cmpinfo = cmpinfo;
+    lin.path = path;
+    lin.rowf = (int *)malloc (sizeof (int) * (lena + 1) * 2);
+    if (NULL == lin.rowf) {
+        return -1;
+    }
+    lin.rowr = lin.rowf + (lena + 1);
+
+    ed_lin_recursive (&lin, 0, lena, 0, lenb);
+    free (lin.rowf);
+
+    assert (lin.numpath <= (size_t)(lena + lenb));
+    *ret_numpath = lin.numpath;
+    return lin.dist;
+}
+
+/**********************************************************************************/
+/* 并行 Hirschberg: 子问题作为任务由多个线程完成 */
+
+#define ED_PLIN_LEAF (1 << 18) /* 面积小于此值的子问题由一个线程顺序完成 */
+
+/* 一个任务: 子问题 a[a0..a1), b[b0..b1), 或者子问题下半部分的反向行(row 不为 NULL) */
+typedef struct _ed_plin_task_t {
+    struct _ed_plin_task_t *next;
+    size_t a0;
+    size_t a1;
+    size_t b0;
+    size_t b1;
+    int *row;      /* 反向行的结果 */
+    int done;      /* 反向行是否已经算完, 由 lock 保护 */
+} ed_plin_task_t;
+
+/**
+ * 子问题 (a0,a1,b0,b1) 的路径长度不超过 (a1-a0)+(b1-b0)，所以写在 path[a0+b0 .. a1+b1) 中，
+ * 不足的部分填 EDIS_NONE。各子问题的区间互不重叠，可以同时写入，全部完成后再压缩。
+ */
+typedef struct _ed_plin_t {
+    strcmp_t *cmpinfo;
+    char *path;
+    int dist;
+    int error;               /* 内存不足, 由 lock 保护 */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;     /* 有新任务, 反向行完成, 或全部完成 */
+    ed_plin_task_t *top;     /* 待处理的任务栈 */
+    size_t pending;          /* 还没有完成的子问题数 */
+    int nworker;             /* 下一个线程的编号, 用于绑定 CPU */
+} ed_plin_t;
+
+/* 调用者持有 lock */
+static void
+ed_plin_push (ed_plin_t *pp, ed_plin_task_t *task)
+{
+    task->next = pp->top;
+    pp->top = task;
+    pthread_cond_broadcast (&(pp->cond));
+}
+
+/* 调用者持有 lock */
+static ed_plin_task_t *
+ed_plin_pop (ed_plin_t *pp)
+{
+    ed_plin_task_t *task = pp->top;
+    if (NULL != task) {
+        pp->top = task->next;
+    }
+    return task;
+}
+
+/* 记录内存不足, 可能有几个线程同时失败 */
+static void
+ed_plin_fail (ed_plin_t *pp)
+{
+    pthread_mutex_lock (&(pp->lock));
+    pp->error = 1;
+    pthread_mutex_unlock (&(pp->lock));
+}
+
+/* 小的子问题: 用 ed_lin_recursive() 写入自己的区间 */
+static void
+ed_plin_leaf (ed_plin_t *pp, size_t a0, size_t a1, size_t b0, size_t b1)
+{
+    ed_linear_t lin;
+    size_t cap = (a1 - a0) + (b1 - b0);
+
+    memset (&lin, 0, sizeof (lin));
+    lin.cmpinfo = pp->cmpinfo;
+    lin.path = pp->path + a0 + b0;
+    lin.rowf = (int *)malloc (sizeof (int) * (a1 - a0 + 1) * 2);
+    if (NULL == lin.rowf) {
+        ed_plin_fail (pp);
+        return;
+    }
+    lin.rowr = lin.rowf + (a1 - a0 + 1);
+    ed_lin_recursive (&lin, a0, a1, b0, b1);
+    free (lin.rowf);
+    assert (lin.numpath <= cap);
+    memset (lin.path + lin.numpath, EDIS_NONE, cap - lin.numpath);
+    __sync_fetch_and_add (&(pp->dist), lin.dist);
+}
+
+static void ed_plin_run (ed_plin_t *pp, ed_plin_task_t *task);
+
+/**
+ * 和 ed_lin_recursive() 的分割相同，所以结果也相同。
+ * 正向行由本线程计算，反向行作为任务交给空闲的线程；等待时本线程也处理栈中的任务。
+ * 上半部分在本线程中继续分割，下半部分作为新任务。
+ */
+static void
+ed_plin_split (ed_plin_t *pp, size_t a0, size_t a1, size_t b0, size_t b1)
+{
+    ed_plin_task_t rev;
+    ed_plin_task_t *task;
+    int *rowf;
+    size_t bmid;
+    size_t j;
+    size_t jmin;
+    int val;
+    int valmin;
+
+    while ((b1 - b0 > 1) && (a1 > a0) && ((a1 - a0) * (b1 - b0) >= ED_PLIN_LEAF)) {
+        rowf = (int *)malloc (sizeof (int) * (a1 - a0 + 1) * 2);
+        if (NULL == rowf) {
+            ed_plin_fail (pp);
+            return;
+        }
+        bmid = b0 + (b1 - b0) / 2;
+        memset (&rev, 0, sizeof (rev));
+        rev.a0 = a0;
+        rev.a1 = a1;
+        rev.b0 = bmid;
+        rev.b1 = b1;
+        rev.row = rowf + (a1 - a0 + 1);
+        pthread_mutex_lock (&(pp->lock));
+        ed_plin_push (pp, &rev);
+        pthread_mutex_unlock (&(pp->lock));
+
+        ed_lin_row_forward (pp->cmpinfo, a0, a1, b0, bmid, rowf);
+
+        pthread_mutex_lock (&(pp->lock));
+        while (! rev.done) {
+            task = ed_plin_pop (pp);
+            if (NULL == task) {
+                pthread_cond_wait (&(pp->cond), &(pp->lock));
+                continue;
+            }
+            pthread_mutex_unlock (&(pp->lock));
+            ed_plin_run (pp, task);
+            pthread_mutex_lock (&(pp->lock));
+        }
+        pthread_mutex_unlock (&(pp->lock));
+
+        jmin = 0;
+        valmin = rowf[0] + rev.row[0];
+        for (j = 1; j <= a1 - a0; j ++) {
+            val = rowf[j] + rev.row[j];
+            if (val < valmin) {
+                valmin = val;
+                jmin = j;
+            }
+        }
+        free (rowf);
+
+        task = (ed_plin_task_t *)malloc (sizeof (ed_plin_task_t));
+        if (NULL == task) {
+            ed_plin_fail (pp);
+            return;
+        }
+        memset (task, 0, sizeof (*task));
+        task->a0 = a0 + jmin;
+        task->a1 = a1;
+        task->b0 = bmid;
+        task->b1 = b1;
+        pthread_mutex_lock (&(pp->lock));
+        pp->pending ++;
+        ed_plin_push (pp, task);
+        pthread_mutex_unlock (&(pp->lock));
+
+        a1 = a0 + jmin;
+        b1 = bmid;
+    }
+    ed_plin_leaf (pp, a0, a1, b0, b1);
+}
+
+static void
+ed_plin_run (ed_plin_t *pp, ed_plin_task_t *task)
+{
+    if (NULL != task->row) {
+        /* 反向行, task 属于等待它的线程 */
+        ed_lin_row_reverse (pp->cmpinfo, task->a0, task->a1, task->b0, task->b1, task->row);
+        pthread_mutex_lock (&(pp->lock));
+        task->done = 1;
+        pthread_cond_broadcast (&(pp->cond));
+        pthread_mutex_unlock (&(pp->lock));
+        return;
+    }
+    ed_plin_split (pp, task->a0, task->a1, task->b0, task->b1);
+    free (task);
+    pthread_mutex_lock (&(pp->lock));
+    pp->pending --;
+    if (0 == pp->pending) {
+        pthread_cond_broadcast (&(pp->cond));
+    }
+    pthread_mutex_unlock (&(pp->lock));
+}
+
+static void *
+ed_plin_worker (void *arg)
+{
+    ed_plin_t *pp = (ed_plin_t *)arg;
+    ed_plin_task_t *task;
+
+    /* 行缓冲由各线程自己分配, 绑定以后总在本地的节点上 */
+    ed_numa_pin_worker (__sync_fetch_and_add (&(pp->nworker), 1));
+    pthread_mutex_lock (&(pp->lock));
+    while (pp->pending > 0) {
+        task = ed_plin_pop (pp);
+        if (NULL == task) {
+            pthread_cond_wait (&(pp->cond), &(pp->lock));
+            continue;
+        }
+        pthread_mutex_unlock (&(pp->lock));
+        ed_plin_run (pp, task);
+        pthread_mutex_lock (&(pp->lock));
+    }
+    pthread_mutex_unlock (&(pp->lock));
+    return NULL;
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, 多线程的线性空间版本
+ *
+ * @param cmpinfo : 字符串的访问接口(cb_comp 会被多个线程同时调用)
+ * @param nthreads : 线程数, < 1 时使用 CPU 的个数
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 内存不足时返回 -1
+ *
+ * 结果和 ed_edit_distance_path_linear() 完全相同(包括路径)。
+ * 每次分割的正向行和反向行同时计算，分割出的子问题放入任务栈，空闲的线程从栈顶取任务。
+ * 空间O((m+n)*线程数)。
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_linear_mt (strcmp_t *cmpinfo, int nthreads, char *path, size_t *ret_numpath)
+{
+    ed_plin_t plin;
+    ed_plin_task_t *task;
+    pthread_t *threads;
+    size_t lena;
+    size_t lenb;
+    size_t i;
+    size_t num;
+    int k;
+
+    assert (NULL != cmpinfo);
+    assert (NULL != cmpinfo->cb_comp);
+    assert (NULL != cmpinfo->cb_len);
+    if (NULL == path) {
+        return ed_edit_distance (cmpinfo);
+    }
+    assert (NULL != ret_numpath);
+    if (nthreads < 1) {
+        nthreads = sysconf (_SC_NPROCESSORS_ONLN);
+        if (nthreads < 1) {
+            nthreads = 1;
+        }
+    }
+    lena = cmpinfo->cb_len(cmpinfo->userdata_str, 0);
+    lenb = cmpinfo->cb_len(cmpinfo->userdata_str, 1);
+
+    memset (&plin, 0, sizeof (plin));
+    plin.cmpinfo = cmpinfo;
+    plin.path = path;
+    task = (ed_plin_task_t *)malloc (sizeof (ed_plin_task_t));
+    threads = (pthread_t *)malloc (sizeof (pthread_t) * nthreads);
+    if ((NULL == task) || (NULL == threads)) {
+        free (threads);
+        free (task);
+        return -1;
+    }
+    memset (task, 0, sizeof (*task));
+    task->a1 = lena;
+    task->b1 = lenb;
+    plin.top = task;
+    plin.pending = 1;
+    pthread_mutex_init (&(plin.lock), NULL);
+    pthread_cond_init (&(plin.cond), NULL);
+    /* 线程创建失败时就用已经创建的线程 */
+    for (k = 1; k < nthreads; k ++) {
+        if (0 != pthread_create (&(threads[k]), NULL, ed_plin_worker, &plin)) {
+            break;
+        }
+    }
+    nthreads = k;
+    ed_plin_worker (&plin);
+    for (k = 1; k < nthreads; k ++) {
+        pthread_join (threads[k], NULL);
+    }
+    ed_numa_unpin ();
+    pthread_cond_destroy (&(plin.cond));
+    pthread_mutex_destroy (&(plin.lock));
+    free (threads);
+    if (plin.error) {
+        return -1;
+    }
+
+    /* 去掉各区间中未用的部分 */
+    for (i = 0, num = 0; i < lena + lenb; i ++) {
+        if (EDIS_NONE != path[i]) {
+            path[num ++] = path[i];
+        }
+    }
+    *ret_numpath = num;
+    return plin.dist;
+}
+
+/**********************************************************************************/
+/* 检查点: 只保存每 k 行的值, 回溯时逐段重新计算 */
+
+/* 由 rows[0] = D[i0][*] 计算 D[i0 + 1 .. i0 + num][*]，每行 lena + 1 个 */
+static void
+ed_ckpt_rows (const wchar_t *stra, size_t lena, const wchar_t *strb, size_t i0, size_t num, int *rows)
+{
+    int *prev;
+    int *cur;
+    size_t r;
+    size_t j;
+    int val;
+
+    for (r = 1; r <= num; r ++) {
+        prev = rows + (r - 1) * (lena + 1);
+        cur = rows + r * (lena + 1);
+        cur[0] = i0 + r;
+        for (j = 1; j <= lena; j ++) {
+            val = prev[j - 1] + ((stra[j - 1] == strb[i0 + r - 1])?0:1);
+            val = MIN (val, prev[j] + 1);
+            val = MIN (val, cur[j - 1] + 1);
+            cur[j] = val;
+        }
+    }
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, 检查点版本
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval, cb_mat* 和 userdata_matrix)
+ * @param k : 每隔 k 行保存一行, 0 -- sqrt(strlen(strb))
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 内存不足时返回 -1
+ *
+ * 结果和 ed_edit_distance_path() 完全相同(包括路径)。
+ * 第一遍只把第 0, k, 2k, ... 行存入 userdata_matrix; 回溯时从下往上，
+ * 每段从它上面的检查点行重新计算至多 k 行到一个临时缓冲中，再按 ed_edit_distance_path() 的规则选择方向。
+ * 时间约为 ed_edit_distance_path() 的两倍，空间O(m*n/k + m*k)，k = sqrt(n) 时为 O(m*sqrt(n))。
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_checkpoint (strcmp_t *cmpinfo, size_t k, char *path, size_t *ret_numpath)
+{
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    int *rows = NULL;
+    int *prev;
+    int *cur;
+    size_t lena = 0;
+    size_t lenb = 0;
+    size_t num;
+    size_t i;
+    size_t j;
+    size_t s;
+    size_t r;
+    int pi; /* Pinsert */
+    int pd; /* Pdelete */
+    int pr; /* Pignore/Preplace */
+    char flg_equ;
+    int ret = -1;
+
+    assert (NULL != cmpinfo);
+    assert (NULL != cmpinfo->cb_matget);
+    assert (NULL != cmpinfo->cb_matset);
+    assert (NULL != cmpinfo->cb_matresz);
+    if (NULL == path) {
+        return ed_edit_distance (cmpinfo);
+    }
+    assert (NULL != ret_numpath);
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL == stra) || (NULL == strb)) {
+        goto end_ckpt;
+    }
+    if (k < 1) {
+        for (k = 1; k * k < lenb; k ++);
+    }
+    if (k > lenb) {
+        k = (lenb > 0)?lenb:1;
+    }
+    rows = (int *)malloc (sizeof (int) * (k + 1) * (lena + 1));
+    if (NULL == rows) {
+        goto end_ckpt;
+    }
+    /* the checkpoint s is the row s * k */
+    if (cmpinfo->cb_matresz (cmpinfo->userdata_matrix, lenb / k + 1, lena + 1) < 0) {
+        goto end_ckpt;
+    }
+
+    for (j = 0; j <= lena; j ++) {
+        rows[j] = j;
+        cmpinfo->cb_matset (cmpinfo->userdata_matrix, 0, j, j);
+    }
+    for (s = 0; s * k < lenb; s ++) {
+        num = MIN (k, lenb - s * k);
+        ed_ckpt_rows (stra, lena, strb, s * k, num, rows);
+        memmove (rows, rows + num * (lena + 1), sizeof (int) * (lena + 1));
+        if (num == k) {
+            for (j = 0; j <= lena; j ++) {
+                cmpinfo->cb_matset (cmpinfo->userdata_matrix, s + 1, j, rows[j]);
+            }
+        }
+    }
+    ret = rows[lena];
+
+    i = lenb;
+    j = lena;
+    num = lena + lenb;
+    while (i > 0) {
+        /* recompute the rows s * k + 1 .. i */
+        s = (i - 1) / k;
+        for (r = 0; r <= lena; r ++) {
+            rows[r] = cmpinfo->cb_matget (cmpinfo->userdata_matrix, s, r);
+        }
+        ed_ckpt_rows (stra, lena, strb, s * k, i - s * k, rows);
+        while (i > s * k) {
+            assert (num > 0);
+            if (0 == j) {
+                path[-- num] = EDIS_INSERT;
+                i --;
+                continue;
+            }
+            r = i - s * k;
+            prev = rows + (r - 1) * (lena + 1);
+            cur = rows + r * (lena + 1);
+            pi = prev[j] + 1;
+            pd = cur[j - 1] + 1;
+            flg_equ = (stra[j - 1] == strb[i - 1]);
+            pr = prev[j - 1] + (flg_equ?0:1);
+            /* 和 ed_edit_distance_path() 的选择顺序一致 */
+            if (pr < pi && pr <= pd) {
+                path[-- num] = (flg_equ?EDIS_IGNORE:EDIS_REPLAC);
+                i --;
+                j --;
+            } else if (pi < pd) {
+                path[-- num] = EDIS_INSERT;
+                i --;
+            } else {
+                path[-- num] = EDIS_DELETE;
+                j --;
+            }
+        }
+    }
+    for (; j > 0; j --) {
+        path[-- num] = EDIS_DELETE;
+    }
+    if (num > 0) {
+        memmove (path, path + num, sizeof (char) * (lena + lenb - num));
+    }
+    *ret_numpath = lena + lenb - num;
+
+end_ckpt:
+    free (rows);
+    free (stra);
+    free (strb);
+    return ret;
+}
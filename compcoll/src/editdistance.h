@@ -29,7 +29,7 @@ typedef wchar_t (* strcmp_cb_getval_t) (void *userdata, int right, size_t idx);
 
 typedef int (* strcmp_cb_matget_t) (void *userdata, size_t idx1, size_t idx2); /* get the value at (idx1, idx2) */
 typedef int (* strcmp_cb_matset_t) (void *userdata, size_t idx1, size_t idx2, int val); /* set the value at (idx1, idx2) */
-typedef int (* strcmp_cb_matresize_t) (void *userdata, size_t row, size_t col); /* resize the matrix to (row, col), and clear it */
+typedef int (* strcmp_cb_matresize_t) (void *userdata, size_t row, size_t col); /* resize the matrix to (row, col), the elements are undefined after it; the algorithms write each one before reading it */
 
 typedef struct _strcmp_t {
     void * userdata_str;
@@ -53,9 +53,43 @@ typedef struct _strcmp_t {
 #define EDIS_REPLAC 0x03 /*!< Replace action */
 #define EDIS_IGNORE 0x04 /*!< Ignore action */
 
+#define EDSIMD_AUTO   0 /*!< Select the best one supported by the CPU */
+#define EDSIMD_SCALAR 1 /*!< No SIMD */
+#define EDSIMD_SSE41  2 /*!< SSE4.1, 8 cells at a time (4 if the values need 32 bits) */
+#define EDSIMD_AVX2   3 /*!< AVX2, 16 cells at a time (8 if the values need 32 bits) */
+
+/* the function to get the edit path, such as ed_edit_distance_path() */
+typedef int (* ed_path_cb_t) (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+
 const char * edaction_val2cstr (char val);
 int ed_edit_distance (strcmp_t *cmpinfo);
+int ed_edit_distance_batch (strcmp_t **cmpinfo, size_t num, int simd, int *ret_dist);
+int ed_edit_distance_bitpar (strcmp_t *cmpinfo);
+int ed_edit_distance_banded (strcmp_t *cmpinfo);
+int ed_edit_distance_bounded (strcmp_t *cmpinfo, int k);
+int ed_qgram_lower_bound (strcmp_t *cmpinfo, size_t q);
 int ed_edit_distance_path (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_recursive (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_linear (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_linear_mt (strcmp_t *cmpinfo, int nthreads, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_checkpoint (strcmp_t *cmpinfo, size_t k, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_myers (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_banded (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_simd (strcmp_t *cmpinfo, int simd, char *path, size_t *ret_numpath);
+int ed_simd_detect (void);
+int ed_edit_distance_path_tiled (strcmp_t *cmpinfo, int nthreads, char *path, size_t *ret_numpath);
+int ed_edit_distance_fast (strcmp_t *cmpinfo);
+int ed_edit_distance_path_fast (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_bitpar (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+int ed_edit_distance_4r (strcmp_t *cmpinfo);
+int ed_edit_distance_path_4r (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_lv (strcmp_t *cmpinfo, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_anchor (strcmp_t *cmpinfo, size_t klen, ed_path_cb_t cb_path, char *path, size_t *ret_numpath);
+int ed_edit_distance_path_trim (strcmp_t *cmpinfo, size_t szprefix, size_t szsuffix, size_t klen, ed_path_cb_t cb_path, char *path, size_t *ret_numpath);
+
+wchar_t * ed_fetch_string (strcmp_t *cmpinfo, int right, size_t *ret_len);
+size_t ed_common_prefix (const wchar_t *stra, const wchar_t *strb, size_t len);
+size_t ed_common_suffix (const wchar_t *stra, size_t lena, const wchar_t *strb, size_t lenb);
 
 #ifdef __cplusplus
 }
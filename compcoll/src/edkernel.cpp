@@ -0,0 +1,397 @@
+/**
+ * @file    edkernel.cpp
+ * @brief   The instances of the edit distance kernels for the C interface
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#include "edkernel.h"
+#include "ednuma.h"
+
+/* 如果矩阵接口就是 mymat_*，则直接访问 mymatrix_t, 省去函数指针调用 */
+static inline bool
+ed_kernel_is_mymat (strcmp_t *cmpinfo)
+{
+    return ((mymat_get == cmpinfo->cb_matget) && (mymat_set == cmpinfo->cb_matset) && (mymat_resize == cmpinfo->cb_matresz));
+}
+
+#define ED_MAX(a,b) (((a)>(b))?(a):(b))
+
+/* the layout of the mymatrix_t */
+static inline bool
+ed_kernel_is_tiled (void *userdata)
+{
+    return (0 != ((mymatrix_t *)userdata)->flg_tiled);
+}
+
+/* the mymatrix_t of mymat_init_delta() */
+static inline bool
+ed_kernel_is_delta (void *userdata)
+{
+    return (MYMAT_COMPACT_DELTA == ((mymatrix_t *)userdata)->flg_compact);
+}
+
+/* 如果矩阵接口是 edmat_*，则按 edmat_create() 时的类型直接访问 ed_typed_matrix */
+static inline bool
+ed_kernel_is_edmat (strcmp_t *cmpinfo)
+{
+    return ((edmat_get == cmpinfo->cb_matget) && (edmat_set == cmpinfo->cb_matset) && (edmat_resize == cmpinfo->cb_matresz));
+}
+
+static inline int
+ed_kernel_edmat_type (void *userdata)
+{
+    return ((ed_matrix_base *)userdata)->type;
+}
+
+/* the types of the values accessed directly, the other ones by the callbacks */
+static inline bool
+ed_kernel_edmat_isval (void *userdata)
+{
+    int type = ed_kernel_edmat_type (userdata);
+    return ((EDMAT_INT8 == type) || (EDMAT_INT16 == type) || (EDMAT_INT32 == type));
+}
+
+/* the types of the directions accessed directly */
+static inline bool
+ed_kernel_edmat_isdir (void *userdata)
+{
+    int type = ed_kernel_edmat_type (userdata);
+    return ((EDMAT_INT8 == type) || (EDMAT_BIT2 == type) || (EDMAT_BIT4 == type));
+}
+
+static inline bool
+ed_kernel_edmat_istiled (void *userdata)
+{
+    return (EDMAT_TILED == ((ed_matrix_base *)userdata)->layout);
+}
+
+template <typename V>
+static int
+ed_kernel_distance_mymat (strcmp_t *cmpinfo, size_t lena, size_t lenb, const ed_callback_equal &equ)
+{
+    if (ed_kernel_is_tiled (cmpinfo->userdata_matrix)) {
+        ed_mymat_matrix<V, true> mat (cmpinfo->userdata_matrix);
+        return ed_kernel_distance (lena, lenb, equ, mat);
+    }
+    ed_mymat_matrix<V> mat (cmpinfo->userdata_matrix);
+    return ed_kernel_distance (lena, lenb, equ, mat);
+}
+
+template <bool TILED>
+static int
+ed_kernel_distance_edmat (strcmp_t *cmpinfo, size_t lena, size_t lenb, const ed_callback_equal &equ)
+{
+    void *u = cmpinfo->userdata_matrix;
+    switch (ed_kernel_edmat_type (u)) {
+    case EDMAT_INT8:
+        return ed_kernel_distance (lena, lenb, equ, edmat_cast<EDMAT_INT8, TILED> (u));
+    case EDMAT_INT16:
+        return ed_kernel_distance (lena, lenb, equ, edmat_cast<EDMAT_INT16, TILED> (u));
+    default:
+        return ed_kernel_distance (lena, lenb, equ, edmat_cast<EDMAT_INT32, TILED> (u));
+    }
+}
+
+int
+ed_kernel_distance_cb (strcmp_t *cmpinfo)
+{
+    size_t lena = cmpinfo->cb_len (cmpinfo->userdata_str, 0);
+    size_t lenb = cmpinfo->cb_len (cmpinfo->userdata_str, 1);
+    ed_callback_equal equ (cmpinfo);
+
+    if (ed_kernel_is_mymat (cmpinfo) && ed_kernel_is_delta (cmpinfo->userdata_matrix)) {
+        /* the row is updated in place, which the deltas can't do; it's only one row */
+        ed_rows_matrix<int> row;
+        return ed_kernel_distance (lena, lenb, equ, row);
+    }
+    if (ed_kernel_is_mymat (cmpinfo)) {
+        switch (mymat_fit (cmpinfo->userdata_matrix, 0, ED_MAX (lena, lenb))) {
+        case sizeof (int8_t):
+            return ed_kernel_distance_mymat<int8_t> (cmpinfo, lena, lenb, equ);
+        case sizeof (int16_t):
+            return ed_kernel_distance_mymat<int16_t> (cmpinfo, lena, lenb, equ);
+        default:
+            return ed_kernel_distance_mymat<int> (cmpinfo, lena, lenb, equ);
+        }
+    }
+    if (ed_kernel_is_edmat (cmpinfo) && ed_kernel_edmat_isval (cmpinfo->userdata_matrix)) {
+        if (ed_kernel_edmat_istiled (cmpinfo->userdata_matrix)) {
+            return ed_kernel_distance_edmat<true> (cmpinfo, lena, lenb, equ);
+        }
+        return ed_kernel_distance_edmat<false> (cmpinfo, lena, lenb, equ);
+    }
+    ed_callback_matrix mat (cmpinfo, cmpinfo->userdata_matrix);
+    return ed_kernel_distance (lena, lenb, equ, mat);
+}
+
+/* fill in the row-major order or by ed_kernel_path_fill_recursive() */
+template <bool RECURSIVE, typename Matrix, typename DirMatrix>
+static inline int
+ed_kernel_path_fill_order (size_t lena, size_t lenb, const ed_callback_equal &equ, Matrix &val, DirMatrix &dir)
+{
+    if (RECURSIVE) {
+        return ed_kernel_path_fill_recursive (lena, lenb, equ, val, dir);
+    }
+    return ed_kernel_path_fill (lena, lenb, equ, val, dir);
+}
+
+/* the directions in the mymatrix_t userdata_matrix2, of the type D */
+template <bool RECURSIVE, typename D, typename Matrix>
+static int
+ed_kernel_path_fill_dir (strcmp_t *cmpinfo, size_t lena, size_t lenb, const ed_callback_equal &equ, Matrix &val)
+{
+    if (ed_kernel_is_tiled (cmpinfo->userdata_matrix2)) {
+        ed_mymat_matrix<D, true> dir (cmpinfo->userdata_matrix2);
+        return ed_kernel_path_fill_order<RECURSIVE> (lena, lenb, equ, val, dir);
+    }
+    ed_mymat_matrix<D> dir (cmpinfo->userdata_matrix2);
+    return ed_kernel_path_fill_order<RECURSIVE> (lena, lenb, equ, val, dir);
+}
+
+/* the directions in the mymatrix_t userdata_matrix2, of the smallest type */
+template <bool RECURSIVE, typename Matrix>
+static int
+ed_kernel_path_fill_mymat_dir (strcmp_t *cmpinfo, size_t lena, size_t lenb, const ed_callback_equal &equ, Matrix &val)
+{
+    if (sizeof (int8_t) == mymat_fit (cmpinfo->userdata_matrix2, EDIS_NONE, EDIS_IGNORE)) {
+        return ed_kernel_path_fill_dir<RECURSIVE, int8_t> (cmpinfo, lena, lenb, equ, val);
+    }
+    return ed_kernel_path_fill_dir<RECURSIVE, int> (cmpinfo, lena, lenb, equ, val);
+}
+
+/* the values are in the element of type V */
+template <bool RECURSIVE, typename V, bool TILED>
+static int
+ed_kernel_path_fill_val (strcmp_t *cmpinfo, size_t lena, size_t lenb, const ed_callback_equal &equ)
+{
+    ed_mymat_matrix<V, TILED> val (cmpinfo->userdata_matrix);
+    return ed_kernel_path_fill_mymat_dir<RECURSIVE> (cmpinfo, lena, lenb, equ, val);
+}
+
+template <bool RECURSIVE, typename V>
+static int
+ed_kernel_path_fill_mymat (strcmp_t *cmpinfo, size_t lena, size_t lenb, const ed_callback_equal &equ)
+{
+    if (ed_kernel_is_tiled (cmpinfo->userdata_matrix)) {
+        return ed_kernel_path_fill_val<RECURSIVE, V, true> (cmpinfo, lena, lenb, equ);
+    }
+    return ed_kernel_path_fill_val<RECURSIVE, V, false> (cmpinfo, lena, lenb, equ);
+}
+
+/* the directions in the ed_typed_matrix userdata_matrix2, of the same layout as the values */
+template <bool RECURSIVE, bool TILED, typename Matrix>
+static int
+ed_kernel_path_fill_edmat_dir (strcmp_t *cmpinfo, size_t lena, size_t lenb, const ed_callback_equal &equ, Matrix &val)
+{
+    void *u = cmpinfo->userdata_matrix2;
+    switch (ed_kernel_edmat_type (u)) {
+    case EDMAT_BIT2:
+        {
+            ed_merged_dir_matrix<ed_typed_matrix<ed_elem_of<EDMAT_BIT2>::type, TILED> > dir (edmat_cast<EDMAT_BIT2, TILED> (u));
+            return ed_kernel_path_fill_order<RECURSIVE> (lena, lenb, equ, val, dir);
+        }
+    case EDMAT_BIT4:
+        return ed_kernel_path_fill_order<RECURSIVE> (lena, lenb, equ, val, edmat_cast<EDMAT_BIT4, TILED> (u));
+    default:
+        return ed_kernel_path_fill_order<RECURSIVE> (lena, lenb, equ, val, edmat_cast<EDMAT_INT8, TILED> (u));
+    }
+}
+
+template <bool RECURSIVE, bool TILED>
+static int
+ed_kernel_path_fill_edmat (strcmp_t *cmpinfo, size_t lena, size_t lenb, const ed_callback_equal &equ)
+{
+    void *u = cmpinfo->userdata_matrix;
+    switch (ed_kernel_edmat_type (u)) {
+    case EDMAT_INT8:
+        return ed_kernel_path_fill_edmat_dir<RECURSIVE, TILED> (cmpinfo, lena, lenb, equ, edmat_cast<EDMAT_INT8, TILED> (u));
+    case EDMAT_INT16:
+        return ed_kernel_path_fill_edmat_dir<RECURSIVE, TILED> (cmpinfo, lena, lenb, equ, edmat_cast<EDMAT_INT16, TILED> (u));
+    default:
+        return ed_kernel_path_fill_edmat_dir<RECURSIVE, TILED> (cmpinfo, lena, lenb, equ, edmat_cast<EDMAT_INT32, TILED> (u));
+    }
+}
+
+template <bool RECURSIVE>
+static int
+ed_kernel_path_fill_any (strcmp_t *cmpinfo)
+{
+    size_t lena = cmpinfo->cb_len (cmpinfo->userdata_str, 0);
+    size_t lenb = cmpinfo->cb_len (cmpinfo->userdata_str, 1);
+    ed_callback_equal equ (cmpinfo);
+
+    if (ed_kernel_is_mymat (cmpinfo) && ed_kernel_is_delta (cmpinfo->userdata_matrix)) {
+        ed_mymat_delta_matrix val (cmpinfo->userdata_matrix);
+        return ed_kernel_path_fill_mymat_dir<RECURSIVE> (cmpinfo, lena, lenb, equ, val);
+    }
+    if (ed_kernel_is_mymat (cmpinfo)) {
+        /* the values are in [0, max(lena, lenb)], a compact matrix uses 1 or 2 bytes for most of the chapters */
+        switch (mymat_fit (cmpinfo->userdata_matrix, 0, ED_MAX (lena, lenb))) {
+        case sizeof (int8_t):
+            return ed_kernel_path_fill_mymat<RECURSIVE, int8_t> (cmpinfo, lena, lenb, equ);
+        case sizeof (int16_t):
+            return ed_kernel_path_fill_mymat<RECURSIVE, int16_t> (cmpinfo, lena, lenb, equ);
+        default:
+            return ed_kernel_path_fill_mymat<RECURSIVE, int> (cmpinfo, lena, lenb, equ);
+        }
+    }
+    ed_callback_matrix val (cmpinfo, cmpinfo->userdata_matrix);
+    ed_callback_matrix dir (cmpinfo, cmpinfo->userdata_matrix2);
+    if (ed_kernel_is_edmat (cmpinfo)) {
+        if (ed_kernel_edmat_isval (cmpinfo->userdata_matrix) && ed_kernel_edmat_isdir (cmpinfo->userdata_matrix2)
+            && (ed_kernel_edmat_istiled (cmpinfo->userdata_matrix) == ed_kernel_edmat_istiled (cmpinfo->userdata_matrix2))) {
+            if (ed_kernel_edmat_istiled (cmpinfo->userdata_matrix)) {
+                return ed_kernel_path_fill_edmat<RECURSIVE, true> (cmpinfo, lena, lenb, equ);
+            }
+            return ed_kernel_path_fill_edmat<RECURSIVE, false> (cmpinfo, lena, lenb, equ);
+        }
+        /* by the callbacks, the directions may be in EDMAT_BIT2 */
+        ed_merged_dir_matrix<ed_callback_matrix> mdir (dir);
+        return ed_kernel_path_fill_order<RECURSIVE> (lena, lenb, equ, val, mdir);
+    }
+    return ed_kernel_path_fill_order<RECURSIVE> (lena, lenb, equ, val, dir);
+}
+
+int
+ed_kernel_path_fill_cb (strcmp_t *cmpinfo)
+{
+    return ed_kernel_path_fill_any<false> (cmpinfo);
+}
+
+int
+ed_kernel_path_fill_recursive_cb (strcmp_t *cmpinfo)
+{
+    return ed_kernel_path_fill_any<true> (cmpinfo);
+}
+
+template <typename D>
+static size_t
+ed_kernel_path_traceback_mymat (strcmp_t *cmpinfo, size_t lena, size_t lenb, const ed_callback_equal &equ, char *path)
+{
+    if (MYMAT_MAP_FILE == ((mymatrix_t *)(cmpinfo->userdata_matrix2))->flg_mmap) {
+        mymat_advise_begin_traceback (cmpinfo->userdata_matrix2);
+        if (ed_kernel_is_tiled (cmpinfo->userdata_matrix2)) {
+            ed_mymat_file_matrix<D, true> dir (cmpinfo->userdata_matrix2);
+            return ed_kernel_path_traceback (lena, lenb, equ, dir, path);
+        }
+        ed_mymat_file_matrix<D> dir (cmpinfo->userdata_matrix2);
+        return ed_kernel_path_traceback (lena, lenb, equ, dir, path);
+    }
+    if (ed_kernel_is_tiled (cmpinfo->userdata_matrix2)) {
+        ed_mymat_matrix<D, true> dir (cmpinfo->userdata_matrix2);
+        return ed_kernel_path_traceback (lena, lenb, equ, dir, path);
+    }
+    ed_mymat_matrix<D> dir (cmpinfo->userdata_matrix2);
+    return ed_kernel_path_traceback (lena, lenb, equ, dir, path);
+}
+
+template <bool TILED>
+static size_t
+ed_kernel_path_traceback_edmat (strcmp_t *cmpinfo, size_t lena, size_t lenb, const ed_callback_equal &equ, char *path)
+{
+    void *u = cmpinfo->userdata_matrix2;
+    switch (ed_kernel_edmat_type (u)) {
+    case EDMAT_BIT2:
+        return ed_kernel_path_traceback (lena, lenb, equ, edmat_cast<EDMAT_BIT2, TILED> (u), path);
+    case EDMAT_BIT4:
+        return ed_kernel_path_traceback (lena, lenb, equ, edmat_cast<EDMAT_BIT4, TILED> (u), path);
+    default:
+        return ed_kernel_path_traceback (lena, lenb, equ, edmat_cast<EDMAT_INT8, TILED> (u), path);
+    }
+}
+
+size_t
+ed_kernel_path_traceback_cb (strcmp_t *cmpinfo, char *path)
+{
+    size_t lena = cmpinfo->cb_len (cmpinfo->userdata_str, 0);
+    size_t lenb = cmpinfo->cb_len (cmpinfo->userdata_str, 1);
+    ed_callback_equal equ (cmpinfo);
+
+    if (ed_kernel_is_mymat (cmpinfo)) {
+        if (sizeof (int8_t) == ((mymatrix_t *)(cmpinfo->userdata_matrix2))->szitem) {
+            return ed_kernel_path_traceback_mymat<int8_t> (cmpinfo, lena, lenb, equ, path);
+        }
+        return ed_kernel_path_traceback_mymat<int> (cmpinfo, lena, lenb, equ, path);
+    }
+    if (ed_kernel_is_edmat (cmpinfo) && ed_kernel_edmat_isdir (cmpinfo->userdata_matrix2)) {
+        if (ed_kernel_edmat_istiled (cmpinfo->userdata_matrix2)) {
+            return ed_kernel_path_traceback_edmat<true> (cmpinfo, lena, lenb, equ, path);
+        }
+        return ed_kernel_path_traceback_edmat<false> (cmpinfo, lena, lenb, equ, path);
+    }
+    ed_callback_matrix dir (cmpinfo, cmpinfo->userdata_matrix2);
+    return ed_kernel_path_traceback (lena, lenb, equ, dir, path);
+}
+
+/**
+ * @brief 计算两个字符串的距离, 编译时特化的版本
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 结果和 ed_edit_distance() 相同。字符串先复制到 wchar_t 数组中，比较和行缓冲都在编译时确定，不再经过 cb_comp 和 cb_mat*。
+ */
+int
+ed_edit_distance_fast (strcmp_t *cmpinfo)
+{
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    int ret = -1;
+
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL != stra) && (NULL != strb)) {
+        ed_array_equal<wchar_t> equ (stra, strb);
+        ed_array_matrix<int> row;
+        ret = ed_kernel_distance (lena, lenb, equ, row);
+    }
+    free (stra);
+    free (strb);
+    return ret;
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, 编译时特化的版本
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 结果和 ed_edit_distance_path() 完全相同(包括路径)。值只保留两行，方向每个格子 2 bits，不使用 cb_mat* 的矩阵。
+ * 时间O(m*n), 空间O(m*n/4) 字节
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_fast (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    int ret = -1;
+
+    if (NULL == path) {
+        return ed_edit_distance_fast (cmpinfo);
+    }
+    assert (NULL != ret_numpath);
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL != stra) && (NULL != strb)) {
+        ed_array_equal<wchar_t> equ (stra, strb);
+        ed_rows_matrix<int> val;
+        ed_packed_dir_matrix dir;
+        ret = ed_kernel_path (lena, lenb, equ, val, dir, path, ret_numpath);
+        ed_numa_account ("packed directions", dir.buf, sizeof (uint64_t) * dir.szword * (lenb + 1));
+    }
+    free (stra);
+    free (strb);
+    return ret;
+}
@@ -0,0 +1,503 @@
+/**
+ * @file    edkernel.h
+ * @brief   The edit distance kernels as C++ templates, specialized at compile time
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#ifndef __MY_EDKERNEL_H
+#define __MY_EDKERNEL_H
+
+#include "editdistance.h"
+#include "mymat.h"
+#include "edmatrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /*__cplusplus*/
+
+/* the instances used by ed_edit_distance() and ed_edit_distance_path() */
+int ed_kernel_distance_cb (strcmp_t *cmpinfo);
+int ed_kernel_path_fill_cb (strcmp_t *cmpinfo);
+int ed_kernel_path_fill_recursive_cb (strcmp_t *cmpinfo);
+size_t ed_kernel_path_traceback_cb (strcmp_t *cmpinfo, char *path);
+
+#ifdef __cplusplus
+}
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*
+ * 模板参数:
+ *   Equal  -- 比较器, equ(idxa, idxb) 为 true 表示 a[idxa] == b[idxb]，字符类型由比较器决定
+ *   Matrix -- 矩阵存储, 需要 resize(row, col), get(row, col), set(row, col, val)
+ * 原来的 strcmp_t 接口每个格子都要通过函数指针调用 cb_comp, cb_matget, cb_matset，
+ * 且每次循环都调用 cb_len; 这里的比较器和矩阵在编译时确定，内层循环可以被编译器内联和优化。
+ */
+
+/* 通过 strcmp_t 的 cb_comp 比较 */
+struct ed_callback_equal {
+    strcmp_t *cmpinfo;
+    explicit ed_callback_equal (strcmp_t *c) : cmpinfo(c) {}
+    bool operator() (size_t idxa, size_t idxb) const {
+        return (0 == cmpinfo->cb_comp (cmpinfo->userdata_str, idxa, idxb));
+    }
+};
+
+/* 直接比较两个数组中的元素 */
+template <typename T>
+struct ed_array_equal {
+    const T *stra;
+    const T *strb;
+    ed_array_equal (const T *a, const T *b) : stra(a), strb(b) {}
+    bool operator() (size_t idxa, size_t idxb) const {
+        return (stra[idxa] == strb[idxb]);
+    }
+};
+
+/* 通过 strcmp_t 的 cb_mat* 访问的矩阵 */
+struct ed_callback_matrix {
+    strcmp_t *cmpinfo;
+    void *userdata;
+    ed_callback_matrix (strcmp_t *c, void *u) : cmpinfo(c), userdata(u) {}
+    int resize (size_t row, size_t col) { return cmpinfo->cb_matresz (userdata, row, col); }
+    int get (size_t row, size_t col) const { return cmpinfo->cb_matget (userdata, row, col); }
+    void set (size_t row, size_t col, int val) { cmpinfo->cb_matset (userdata, row, col, val); }
+};
+
+/* 直接访问的 mymatrix_t, 元素类型 T 的大小为 mymat_fit() 返回的值; TILED 为 true 时按块存储(mymat_set_tiled()) */
+template <typename T, bool TILED = false>
+struct ed_mymat_matrix {
+    mymatrix_t *pm;
+    explicit ed_mymat_matrix (void *u) : pm((mymatrix_t *)u) { assert (sizeof (T) == pm->szitem); assert (TILED == !!(pm->flg_tiled)); }
+    int resize (size_t row, size_t col) { return mymat_resize (pm, row, col); }
+    size_t index (size_t row, size_t col) const { return (TILED?mymat_index_tiled (pm, row, col):(row * pm->szcol + col)); }
+    int get (size_t row, size_t col) const { return ((const T *)(pm->buf))[index (row, col)]; }
+    void set (size_t row, size_t col, int val) { ((T *)(pm->buf))[index (row, col)] = (T)val; }
+};
+
+/* 直接访问的 delta 模式的 mymatrix_t(mymat_init_delta()), 同一行的格子需要从左到右设置, 所以不能用于 ed_kernel_distance() */
+struct ed_mymat_delta_matrix {
+    mymatrix_t *pm;
+    explicit ed_mymat_delta_matrix (void *u) : pm((mymatrix_t *)u) { assert (MYMAT_COMPACT_DELTA == pm->flg_compact); }
+    int resize (size_t row, size_t col) { return mymat_resize (pm, row, col); }
+    int get (size_t row, size_t col) const { return mymat_get_delta (pm, row, col); }
+    void set (size_t row, size_t col, int val) { mymat_set_delta (pm, row, col, val); }
+};
+
+/* 缓冲在临时文件中的 ed_mymat_matrix(mymat_set_file()): 回溯每进入新的 MYMAT_TILE 行就提示内核预读上面的行 */
+template <typename T, bool TILED = false>
+struct ed_mymat_file_matrix : public ed_mymat_matrix<T, TILED> {
+    mutable size_t band;
+    explicit ed_mymat_file_matrix (void *u) : ed_mymat_matrix<T, TILED>(u), band(SIZE_MAX) {}
+    int get (size_t row, size_t col) const {
+        if ((row >> MYMAT_TILE_BITS) != band) {
+            band = row >> MYMAT_TILE_BITS;
+            mymat_advise_traceback (this->pm, row);
+        }
+        return ed_mymat_matrix<T, TILED>::get (row, col);
+    }
+};
+
+/* 自己管理内存的数组, 元素类型为 V */
+template <typename V>
+struct ed_array_matrix {
+    V *buf;
+    size_t szcol;
+    ed_array_matrix () : buf(NULL), szcol(0) {}
+    ~ed_array_matrix () { free (buf); }
+    int resize (size_t row, size_t col) {
+        V *newbuf = (V *)realloc (buf, sizeof (V) * row * col);
+        if (NULL == newbuf) {
+            return -1;
+        }
+        buf = newbuf;
+        szcol = col;
+        return 0;
+    }
+    int get (size_t row, size_t col) const { return buf[row * szcol + col]; }
+    void set (size_t row, size_t col, int val) { buf[row * szcol + col] = (V)val; }
+private:
+    ed_array_matrix (const ed_array_matrix &);
+    ed_array_matrix & operator= (const ed_array_matrix &);
+};
+
+/* 只保留最近两行的矩阵: 第 row 行存在 row % 2 */
+template <typename V>
+struct ed_rows_matrix : public ed_array_matrix<V> {
+    int resize (size_t row, size_t col) { return ed_array_matrix<V>::resize ((row < 2)?row:2, col); }
+    int get (size_t row, size_t col) const { return ed_array_matrix<V>::get (row & 1, col); }
+    void set (size_t row, size_t col, int val) { ed_array_matrix<V>::set (row & 1, col, val); }
+};
+
+/**
+ * 方向矩阵, 每个格子 2 bits, 每行按 64 bits 的字对齐:
+ *   EDIS_NONE, EDIS_INSERT, EDIS_DELETE 原样保存, EDIS_REPLAC 和 EDIS_IGNORE 都保存为 EDIS_REPLAC,
+ *   回溯时再比较字符来区分。比每个格子一个 int 少用 16 倍的内存。
+ * 写操作先合并到缓存的一个字中，换字的时候才写回内存。
+ */
+struct ed_packed_dir_matrix {
+    uint64_t *buf;
+    size_t szword;  /* the number of words per row */
+    size_t idxcur;  /* the index of the cached word */
+    uint64_t wcur;  /* the cached word */
+    ed_packed_dir_matrix () : buf(NULL), szword(0), idxcur(0), wcur(0) {}
+    ~ed_packed_dir_matrix () { free (buf); }
+    int resize (size_t row, size_t col) {
+        free (buf);
+        szword = (col + 31) / 32;
+        buf = (uint64_t *)calloc (row * szword + 1, sizeof (uint64_t));
+        idxcur = 0;
+        wcur = 0;
+        return ((NULL == buf)?-1:0);
+    }
+    int get (size_t row, size_t col) const {
+        size_t idx = row * szword + col / 32;
+        uint64_t w = ((idx == idxcur)?wcur:buf[idx]);
+        return (int)((w >> ((col % 32) * 2)) & 0x03);
+    }
+    void set (size_t row, size_t col, int val) {
+        size_t idx = row * szword + col / 32;
+        unsigned int shift = (col % 32) * 2;
+        if (idx != idxcur) {
+            buf[idxcur] = wcur;
+            idxcur = idx;
+            wcur = buf[idx];
+        }
+        wcur = (wcur & ~((uint64_t)0x03 << shift)) | ((uint64_t)((val > EDIS_REPLAC)?EDIS_REPLAC:val) << shift);
+    }
+private:
+    ed_packed_dir_matrix (const ed_packed_dir_matrix &);
+    ed_packed_dir_matrix & operator= (const ed_packed_dir_matrix &);
+};
+
+/* 方向只有 2 bits 时把 EDIS_IGNORE 保存为 EDIS_REPLAC(同 ed_packed_dir_matrix), 回溯时再比较字符来区分 */
+template <typename DirMatrix>
+struct ed_merged_dir_matrix {
+    DirMatrix &mat;
+    explicit ed_merged_dir_matrix (DirMatrix &m) : mat(m) {}
+    int resize (size_t row, size_t col) { return mat.resize (row, col); }
+    int get (size_t row, size_t col) const { return mat.get (row, col); }
+    void set (size_t row, size_t col, int val) { mat.set (row, col, (val > EDIS_REPLAC)?EDIS_REPLAC:val); }
+};
+
+/**
+ * @brief 计算两个字符串的距离, 只用一行的空间, 同 ed_edit_distance()
+ *
+ * @return 返回距离值, 内存不足时返回 -1
+ */
+template <typename Equal, typename Matrix>
+int
+ed_kernel_distance (size_t lena, size_t lenb, const Equal &equ, Matrix &mat)
+{
+    size_t i;
+    size_t j;
+    int pi; /* Pinsert */
+    int pd; /* Pdelete */
+    int pr; /* Pignore/Preplace */
+    int crossval; /* 斜临的值 */
+
+    if (lena < 1) {
+        return lenb;
+    }
+    if (lenb < 1) {
+        return lena;
+    }
+    if (mat.resize (1, lena + 1) < 0) {
+        return -1;
+    }
+    for (j = 0; j <= lena; j ++) {
+        mat.set (0, j, j);
+    }
+    for (i = 1; i <= lenb; i ++) {
+        crossval = i - 1;
+        pd = i + 1; /* 因为在这0列上的值是固定的 */
+        for (j = 1; j <= lena; j ++) {
+            pi = 1 + mat.get (0, j);
+            pr = crossval + (equ (j - 1, i - 1)?0:1);
+            pi = (pi < pd)?pi:pd;
+            crossval = mat.get (0, j);
+            pd = (pi < pr)?pi:pr;
+            mat.set (0, j, pd);
+            pd ++;
+        }
+    }
+    return mat.get (0, lena);
+}
+
+/* 逐行计算 [i0, i1) x [j0, j1) 中格子的值和方向, 上边和左边的格子已经算好 */
+template <typename Equal, typename Matrix, typename DirMatrix>
+static void
+ed_kernel_path_fill_rect (size_t i0, size_t i1, size_t j0, size_t j1, const Equal &equ, Matrix &val, DirMatrix &dir)
+{
+    size_t i;
+    size_t j;
+    int pi; /* Pinsert */
+    int pd; /* Pdelete */
+    int pr; /* Pignore/Preplace */
+    bool flg_equ;
+
+    for (i = i0; i < i1; i ++) {
+        for (j = j0; j < j1; j ++) {
+            pi = 1 + val.get (i - 1, j);
+            pd = 1 + val.get (i, j - 1);
+            flg_equ = equ (j - 1, i - 1);
+            pr = val.get (i - 1, j - 1) + (flg_equ?0:1);
+            /* the same choice as the if-else tree of ed_edit_distance_path() */
+            if (pr < pi && pr <= pd) {
+                val.set (i, j, pr);
+                dir.set (i, j, (flg_equ?EDIS_IGNORE:EDIS_REPLAC));
+            } else if (pi < pd) {
+                val.set (i, j, pi);
+                dir.set (i, j, EDIS_INSERT);
+            } else {
+                val.set (i, j, pd);
+                dir.set (i, j, EDIS_DELETE);
+            }
+        }
+    }
+}
+
+/* ed_kernel_path_fill_rect() 的 delta 模式: 上一行逐个加上 delta 位, 本行直接写入 delta 位, 每行只有开头需要 popcount */
+template <typename Equal, typename DirMatrix>
+static void
+ed_kernel_path_fill_rect (size_t i0, size_t i1, size_t j0, size_t j1, const Equal &equ, ed_mymat_delta_matrix &val, DirMatrix &dir)
+{
+    mymatrix_t *pm = val.pm;
+    uint64_t *words = (uint64_t *)(pm->buf);
+    int32_t *first = (int32_t *)(words + 2 * pm->szbuf);
+    size_t nblk = (pm->szcol + MYMAT_DELTA_MASK) >> MYMAT_DELTA_BITS;
+    size_t i;
+    size_t j;
+    size_t blkup; /* the block of (i - 1, j) */
+    size_t blk;   /* the block of (i, j) */
+    uint64_t bit;
+    unsigned int k;
+    int up;   /* (i - 1, j) */
+    int left; /* (i, j - 1) */
+    int diag; /* (i - 1, j - 1) */
+    int cur;
+    bool flg_equ;
+
+    for (i = i0; i < i1; i ++) {
+        up = mymat_get_delta (pm, i - 1, j0 - 1);
+        left = mymat_get_delta (pm, i, j0 - 1);
+        for (j = j0; j < j1; j ++) {
+            k = j & MYMAT_DELTA_MASK;
+            blkup = (i - 1) * nblk + (j >> MYMAT_DELTA_BITS);
+            blk = blkup + nblk;
+            diag = up;
+            if (0 == k) {
+                up = first[blkup];
+            } else {
+                up += (int)((words[2 * blkup] >> k) & 1) - (int)((words[2 * blkup + 1] >> k) & 1);
+            }
+            flg_equ = equ (j - 1, i - 1);
+            cur = diag + (flg_equ?0:1);
+            /* the same choice as the generic one */
+            if (cur < up + 1 && cur <= left + 1) {
+                dir.set (i, j, (flg_equ?EDIS_IGNORE:EDIS_REPLAC));
+            } else if (up < left) {
+                cur = up + 1;
+                dir.set (i, j, EDIS_INSERT);
+            } else {
+                cur = left + 1;
+                dir.set (i, j, EDIS_DELETE);
+            }
+            if (0 == k) {
+                first[blk] = cur;
+                words[2 * blk] = 0;
+                words[2 * blk + 1] = 0;
+            } else {
+                bit = (uint64_t)1 << k;
+                words[2 * blk] = (words[2 * blk] & ~bit) | ((cur > left)?bit:0);
+                words[2 * blk + 1] = (words[2 * blk + 1] & ~bit) | ((cur < left)?bit:0);
+            }
+            left = cur;
+        }
+    }
+}
+
+/**
+ * @brief 填充整个矩阵的值和方向, 同 ed_edit_distance_path()
+ *
+ * @return 返回距离值, 内存不足时返回 -1
+ */
+template <typename Equal, typename Matrix, typename DirMatrix>
+int
+ed_kernel_path_fill (size_t lena, size_t lenb, const Equal &equ, Matrix &val, DirMatrix &dir)
+{
+    size_t i;
+    size_t j;
+
+    if (val.resize (lenb + 1, lena + 1) < 0) {
+        return -1;
+    }
+    if (dir.resize (lenb + 1, lena + 1) < 0) {
+        return -1;
+    }
+    for (j = 0; j <= lena; j ++) {
+        val.set (0, j, j);
+        dir.set (0, j, EDIS_DELETE);
+    }
+    dir.set (0, 0, EDIS_NONE);
+    for (i = 1; i <= lenb; i ++) {
+        /* 第0列在行内设置, 这样值矩阵可以只保留两行 */
+        val.set (i, 0, i);
+        dir.set (i, 0, EDIS_INSERT);
+        ed_kernel_path_fill_rect (i, i + 1, 1, lena + 1, equ, val, dir);
+    }
+    return val.get (lenb, lena);
+}
+
+#define ED_RECURSIVE_LEAF 256 /* the rows and columns of the block filled by the loops */
+
+/* 递归填充 [i0, i1) x [j0, j1): 把较长的一边分成两半，先算上(左)半部分再算下(右)半部分 */
+template <typename Equal, typename Matrix, typename DirMatrix>
+static void
+ed_kernel_path_fill_block (size_t i0, size_t i1, size_t j0, size_t j1, const Equal &equ, Matrix &val, DirMatrix &dir)
+{
+    if (i1 - i0 > ED_RECURSIVE_LEAF || j1 - j0 > ED_RECURSIVE_LEAF) {
+        if (i1 - i0 >= j1 - j0) {
+            ed_kernel_path_fill_block (i0, (i0 + i1) / 2, j0, j1, equ, val, dir);
+            ed_kernel_path_fill_block ((i0 + i1) / 2, i1, j0, j1, equ, val, dir);
+        } else {
+            ed_kernel_path_fill_block (i0, i1, j0, (j0 + j1) / 2, equ, val, dir);
+            ed_kernel_path_fill_block (i0, i1, (j0 + j1) / 2, j1, equ, val, dir);
+        }
+        return;
+    }
+    ed_kernel_path_fill_rect (i0, i1, j0, j1, equ, val, dir);
+}
+
+/**
+ * @brief 按递归的顺序填充整个矩阵的值和方向, 结果同 ed_kernel_path_fill()
+ *
+ * @return 返回距离值, 内存不足时返回 -1
+ *
+ * 按行填充时每一行都要读写整行，行宽超过缓存时相邻两行无法同时留在缓存中。
+ * 递归地把矩阵分成两半直到 ED_RECURSIVE_LEAF x ED_RECURSIVE_LEAF 的小块，
+ * 每一小块所用的数据总能放进某一级缓存(cache-oblivious), 不需要知道缓存的大小。
+ * 矩阵需要保存所有的行(不能用 ed_rows_matrix), 配合按块存储的 mymatrix_t 效果更好。
+ */
+template <typename Equal, typename Matrix, typename DirMatrix>
+int
+ed_kernel_path_fill_recursive (size_t lena, size_t lenb, const Equal &equ, Matrix &val, DirMatrix &dir)
+{
+    size_t i;
+    size_t j;
+
+    if (val.resize (lenb + 1, lena + 1) < 0) {
+        return -1;
+    }
+    if (dir.resize (lenb + 1, lena + 1) < 0) {
+        return -1;
+    }
+    for (j = 0; j <= lena; j ++) {
+        val.set (0, j, j);
+        dir.set (0, j, EDIS_DELETE);
+    }
+    dir.set (0, 0, EDIS_NONE);
+    for (i = 1; i <= lenb; i ++) {
+        val.set (i, 0, i);
+        dir.set (i, 0, EDIS_INSERT);
+    }
+    ed_kernel_path_fill_block (1, lenb + 1, 1, lena + 1, equ, val, dir);
+    return val.get (lenb, lena);
+}
+
+/**
+ * @brief 从 (lenb, lena) 沿方向回溯到 (0, 0)
+ *
+ * @return 返回路径的长度
+ *
+ * 对角线的方向由比较字符来确定是 EDIS_IGNORE 还是 EDIS_REPLAC, 所以方向矩阵可以不区分这两者
+ */
+template <typename Equal, typename DirMatrix>
+size_t
+ed_kernel_path_traceback (size_t lena, size_t lenb, const Equal &equ, const DirMatrix &dir, char *path)
+{
+    size_t i = lenb;
+    size_t j = lena;
+    size_t num = lena + lenb;
+    char action;
+
+    while (num > 0) {
+        action = dir.get (i, j);
+        if (EDIS_NONE == action) {
+            break;
+        }
+        if (EDIS_REPLAC == action || EDIS_IGNORE == action) {
+            action = (equ (j - 1, i - 1)?EDIS_IGNORE:EDIS_REPLAC);
+        }
+        path[-- num] = action;
+        switch (action) {
+        case EDIS_INSERT:
+            i --;
+            break;
+        case EDIS_DELETE:
+            j --;
+            break;
+        case EDIS_REPLAC:
+        case EDIS_IGNORE:
+            i --;
+            j --;
+            break;
+        default:
+            assert (0);
+            break;
+        }
+    }
+    if (num > 0) {
+        memmove (path, path + num, sizeof (char) * (lena + lenb - num));
+    }
+    return lena + lenb - num;
+}
+
+/* 一个字符串为空时的路径 */
+static inline int
+ed_kernel_path_empty (size_t lena, size_t lenb, char *path, size_t *ret_numpath)
+{
+    size_t i;
+    if (lena < 1) {
+        for (i = 0; i < lenb; i ++) {
+            path[i] = EDIS_INSERT;
+        }
+        *ret_numpath = lenb;
+        return lenb;
+    }
+    for (i = 0; i < lena; i ++) {
+        path[i] = EDIS_DELETE;
+    }
+    *ret_numpath = lena;
+    return lena;
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径
+ *
+ * @return 返回距离值, 内存不足时返回 -1
+ */
+template <typename Equal, typename Matrix, typename DirMatrix>
+int
+ed_kernel_path (size_t lena, size_t lenb, const Equal &equ, Matrix &val, DirMatrix &dir, char *path, size_t *ret_numpath)
+{
+    int ret;
+    if (lena < 1 || lenb < 1) {
+        return ed_kernel_path_empty (lena, lenb, path, ret_numpath);
+    }
+    ret = ed_kernel_path_fill (lena, lenb, equ, val, dir);
+    if (ret < 0) {
+        return ret;
+    }
+    *ret_numpath = ed_kernel_path_traceback (lena, lenb, equ, dir, path);
+    return ret;
+}
+
+#endif /*__cplusplus*/
+#endif /* __MY_EDKERNEL_H */
@@ -0,0 +1,403 @@
+/**
+ * @file    edlv.c
+ * @brief   Edit distance path by the diagonal transition (Landau-Vishkin 1989), time O((m+n)*log(m+n) + D^2),
+ *          memory O(D^2) for all of the L[e] levels plus O((m+n)*log(m+n)) for the suffix array and the sparse table
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "editdistance.h"
+
+#define EDLV_NONE (INT_MIN / 2) /* the diagonal is not reached */
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+#define MAX(a,b) (((a)>(b))?(a):(b))
+
+/**
+ * 对角线 k = x - y, x 为 a 中的位置, y 为 b 中的位置。
+ * L[e][k] 为用 e 次编辑在对角线 k 上能到达的最远的 x:
+ *   x = max (L[e-1][k] + 1 (替换), L[e-1][k-1] + 1 (删除 a 中的字符), L[e-1][k+1] (插入 b 中的字符))
+ *   然后沿对角线滑过相同的字符: x += LCE(x, x - k)
+ * 当 L[e][lena - lenb] == lena 时 e 就是编辑距离。
+ *
+ * LCE (longest common extension) 用 a、b 连接后的后缀数组、LCP 数组和稀疏表(RMQ)计算，每次 O(1)。
+ * 所有的 L[e] 都保留下来用于回溯，空间 O(D^2)，所以只适合差异较小的文本。
+ * 后缀数组的建立(前缀倍增)和稀疏表另外需要 O((m+n)*log(m+n)) 的时间和空间。
+ */
+typedef struct _ed_lce_t {
+    int lena;
+    int lenb;
+    int num;        /* the length of the text: a, separator, b, sentinel */
+    int *rank;      /* rank[i] -- the rank of the suffix at i */
+    int *sparse;    /* the sparse table of the LCP array, (log2(num) + 1) x num */
+    int levels;
+} ed_lce_t;
+
+static int
+ed_lce_cmpwc (const void *p1, const void *p2)
+{
+    wchar_t c1 = *(const wchar_t *)p1;
+    wchar_t c2 = *(const wchar_t *)p2;
+    return ((c1 < c2)?-1:((c1 > c2)?1:0));
+}
+
+/* 把字符映射到 2 .. sigma+1, 分隔符为 1, 结尾为 0; 返回字符集的大小 */
+static int
+ed_lce_text (const wchar_t *stra, int lena, const wchar_t *strb, int lenb, int *text)
+{
+    wchar_t *alpha;
+    wchar_t *pw;
+    int num = 0;
+    int i;
+
+    alpha = (wchar_t *)malloc (sizeof (wchar_t) * (lena + lenb + 1));
+    if (NULL == alpha) {
+        return -1;
+    }
+    memcpy (alpha, stra, sizeof (wchar_t) * lena);
+    memcpy (alpha + lena, strb, sizeof (wchar_t) * lenb);
+    qsort (alpha, lena + lenb, sizeof (wchar_t), ed_lce_cmpwc);
+    for (i = 0; i < lena + lenb; i ++) {
+        if ((0 == num) || (alpha[num - 1] != alpha[i])) {
+            alpha[num ++] = alpha[i];
+        }
+    }
+    for (i = 0; i < lena; i ++) {
+        pw = (wchar_t *)bsearch (stra + i, alpha, num, sizeof (wchar_t), ed_lce_cmpwc);
+        text[i] = pw - alpha + 2;
+    }
+    text[lena] = 1;
+    for (i = 0; i < lenb; i ++) {
+        pw = (wchar_t *)bsearch (strb + i, alpha, num, sizeof (wchar_t), ed_lce_cmpwc);
+        text[lena + 1 + i] = pw - alpha + 2;
+    }
+    text[lena + lenb + 1] = 0;
+    free (alpha);
+    return num + 2;
+}
+
+/**
+ * @brief 建立后缀数组(前缀倍增, 基数排序), 以及 LCP 的稀疏表
+ *
+ * @return 成功返回 0, 失败返回 -1
+ */
+static int
+ed_lce_init (ed_lce_t *plce, const wchar_t *stra, int lena, const wchar_t *strb, int lenb)
+{
+    int *text = NULL;
+    int *sa = NULL;
+    int *tmp = NULL;
+    int *cnt = NULL;
+    int *lcp;
+    int num = lena + lenb + 2;
+    int sigma;
+    int i;
+    int j;
+    int k;
+    int h;
+    int r;
+    int ret = -1;
+
+    memset (plce, 0, sizeof (*plce));
+    plce->lena = lena;
+    plce->lenb = lenb;
+    plce->num = num;
+    for (plce->levels = 1; (1 << plce->levels) <= num; plce->levels ++);
+    text = (int *)malloc (sizeof (int) * num);
+    sa = (int *)calloc (num, sizeof (int));
+    tmp = (int *)malloc (sizeof (int) * num);
+    cnt = (int *)malloc (sizeof (int) * (num + 1));
+    plce->rank = (int *)malloc (sizeof (int) * num);
+    plce->sparse = (int *)malloc (sizeof (int) * num * plce->levels);
+    if ((NULL == text) || (NULL == sa) || (NULL == tmp) || (NULL == cnt) || (NULL == plce->rank) || (NULL == plce->sparse)) {
+        goto end_lce;
+    }
+    sigma = ed_lce_text (stra, lena, strb, lenb, text);
+    if (sigma < 0) {
+        goto end_lce;
+    }
+
+    /* the suffixes sorted by the first character */
+    memset (cnt, 0, sizeof (int) * (num + 1));
+    for (i = 0; i < num; i ++) {
+        cnt[text[i]] ++;
+    }
+    for (i = 1; i < sigma; i ++) {
+        cnt[i] += cnt[i - 1];
+    }
+    for (i = num - 1; i >= 0; i --) {
+        sa[-- cnt[text[i]]] = i;
+    }
+    plce->rank[sa[0]] = 0;
+    for (i = 1, r = 0; i < num; i ++) {
+        if (text[sa[i]] != text[sa[i - 1]]) {
+            r ++;
+        }
+        plce->rank[sa[i]] = r;
+    }
+    /* sorted by the first 2k characters, (rank[i], rank[i + k]) */
+    for (k = 1; r < num - 1; k <<= 1) {
+        j = 0;
+        for (i = num - k; i < num; i ++) {
+            tmp[j ++] = i;
+        }
+        for (i = 0; i < num; i ++) {
+            if (sa[i] >= k) {
+                tmp[j ++] = sa[i] - k;
+            }
+        }
+        memset (cnt, 0, sizeof (int) * (num + 1));
+        for (i = 0; i < num; i ++) {
+            cnt[plce->rank[i]] ++;
+        }
+        for (i = 1; i <= r; i ++) {
+            cnt[i] += cnt[i - 1];
+        }
+        for (i = num - 1; i >= 0; i --) {
+            sa[-- cnt[plce->rank[tmp[i]]]] = tmp[i];
+        }
+        tmp[sa[0]] = 0;
+        for (i = 1, r = 0; i < num; i ++) {
+            if ((plce->rank[sa[i]] != plce->rank[sa[i - 1]])
+                || (((sa[i] + k < num)?plce->rank[sa[i] + k]:-1) != ((sa[i - 1] + k < num)?plce->rank[sa[i - 1] + k]:-1))) {
+                r ++;
+            }
+            tmp[sa[i]] = r;
+        }
+        memcpy (plce->rank, tmp, sizeof (int) * num);
+    }
+
+    /* LCP (Kasai), lcp[r] is the LCP of the suffixes sa[r - 1] and sa[r] */
+    lcp = plce->sparse;
+    lcp[0] = 0;
+    for (i = 0, h = 0; i < num; i ++) {
+        if (plce->rank[i] > 0) {
+            j = sa[plce->rank[i] - 1];
+            while ((i + h < num) && (j + h < num) && (text[i + h] == text[j + h])) {
+                h ++;
+            }
+            lcp[plce->rank[i]] = h;
+            if (h > 0) {
+                h --;
+            }
+        } else {
+            h = 0;
+        }
+    }
+    /* sparse[l][r] = min (lcp[r .. r + 2^l - 1]) */
+    for (k = 1; k < plce->levels; k ++) {
+        int *prev = plce->sparse + (size_t)(k - 1) * num;
+        int *cur = plce->sparse + (size_t)k * num;
+        for (i = 0; i + (1 << k) <= num; i ++) {
+            cur[i] = MIN (prev[i], prev[i + (1 << (k - 1))]);
+        }
+    }
+    ret = 0;
+
+end_lce:
+    free (cnt);
+    free (tmp);
+    free (sa);
+    free (text);
+    return ret;
+}
+
+static void
+ed_lce_clear (ed_lce_t *plce)
+{
+    free (plce->rank);
+    free (plce->sparse);
+    memset (plce, 0, sizeof (*plce));
+}
+
+/* the length of the common prefix of a[x ..] and b[y ..] */
+static int
+ed_lce_query (const ed_lce_t *plce, int x, int y)
+{
+    int r1;
+    int r2;
+    int l;
+
+    if ((x >= plce->lena) || (y >= plce->lenb)) {
+        return 0;
+    }
+    r1 = plce->rank[x];
+    r2 = plce->rank[plce->lena + 1 + y];
+    if (r1 > r2) {
+        l = r1;
+        r1 = r2;
+        r2 = l;
+    }
+    /* min (lcp[r1 + 1 .. r2]) */
+    r1 ++;
+    l = 31 - __builtin_clz (r2 - r1 + 1);
+    return MIN (plce->sparse[(size_t)l * plce->num + r1], plce->sparse[(size_t)l * plce->num + r2 - (1 << l) + 1]);
+}
+
+/* L[e] 只保存对角线 -e .. e, 第 e 层从 e * e 开始 */
+#define EDLV_IDX(e, k) ((size_t)(e) * (e) + (e) + (k))
+
+/* 第 e-1 层中对角线 k 的值 */
+static int
+ed_lv_prev (const int *furthest, int e, int k)
+{
+    if ((e < 1) || (k < -(e - 1)) || (k > e - 1)) {
+        return EDLV_NONE;
+    }
+    return furthest[EDLV_IDX (e - 1, k)];
+}
+
+/**
+ * @brief 用 e 次编辑到达对角线 k 的起点(滑动之前)
+ *
+ * @param ret_action : 返回最后一次编辑
+ *
+ * @return 返回 x, 不可到达时为 EDLV_NONE
+ */
+static int
+ed_lv_step (const int *furthest, int lena, int lenb, int e, int k, char *ret_action)
+{
+    int x = EDLV_NONE;
+    int c;
+
+    /* the order of the choices is the same as the traceback */
+    c = ed_lv_prev (furthest, e, k);
+    if ((c > EDLV_NONE) && (c + 1 <= lena) && (c + 1 - k <= lenb)) {
+        x = c + 1;
+        *ret_action = EDIS_REPLAC;
+    }
+    c = ed_lv_prev (furthest, e, k - 1);
+    if ((c > EDLV_NONE) && (c + 1 <= lena) && (c + 1 > x)) {
+        x = c + 1;
+        *ret_action = EDIS_DELETE;
+    }
+    c = ed_lv_prev (furthest, e, k + 1);
+    if ((c > EDLV_NONE) && (c - k <= lenb) && (c > x)) {
+        x = c;
+        *ret_action = EDIS_INSERT;
+    }
+    return x;
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, 对角线转移版本
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 距离和 ed_edit_distance_path() 相同, 路径可能不同。时间O((m+n)*log(m+n) + D^2), 空间O((m+n)*log(m+n) + D^2)
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_lv (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    ed_lce_t lce;
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    int *furthest = NULL;
+    int *newbuf;
+    size_t szbuf = 0;
+    size_t lena = 0;
+    size_t lenb = 0;
+    size_t num;
+    int delta;
+    int e;
+    int k;
+    int x;
+    int x0;
+    char action = EDIS_NONE;
+    int ret = -1;
+
+    assert (NULL != cmpinfo);
+    assert (NULL != path);
+    assert (NULL != ret_numpath);
+    memset (&lce, 0, sizeof (lce));
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL == stra) || (NULL == strb)) {
+        goto end_lv;
+    }
+    if (ed_lce_init (&lce, stra, lena, strb, lenb) < 0) {
+        goto end_lv;
+    }
+    delta = (int)lena - (int)lenb;
+    for (e = 0; ; e ++) {
+        if (EDLV_IDX (e, e) >= szbuf) {
+            szbuf = EDLV_IDX (e, e) * 2 + 16;
+            newbuf = (int *)realloc (furthest, sizeof (int) * szbuf);
+            if (NULL == newbuf) {
+                goto end_lv;
+            }
+            furthest = newbuf;
+        }
+        for (k = -e; k <= e; k ++) {
+            if (0 == e) {
+                x = 0;
+            } else if ((k < -(int)lenb) || (k > (int)lena)) {
+                x = EDLV_NONE;
+            } else {
+                x = ed_lv_step (furthest, lena, lenb, e, k, &action);
+            }
+            if (x > EDLV_NONE) {
+                x += ed_lce_query (&lce, x, x - k);
+            }
+            furthest[EDLV_IDX (e, k)] = x;
+        }
+        if ((abs (delta) <= e) && (furthest[EDLV_IDX (e, delta)] >= (int)lena)) {
+            break;
+        }
+    }
+    ret = e;
+
+    /* 回溯: 从 (e, delta) 找到每一步的来源 */
+    num = lena + lenb;
+    k = delta;
+    x = lena;
+    for (; e >= 0; e --) {
+        x0 = ((0 == e)?0:ed_lv_step (furthest, lena, lenb, e, k, &action));
+        assert (x0 <= x);
+        for (; x > x0; x --) {
+            assert (num > 0);
+            path[-- num] = EDIS_IGNORE;
+        }
+        if (0 == e) {
+            break;
+        }
+        assert (num > 0);
+        path[-- num] = action;
+        switch (action) {
+        case EDIS_REPLAC:
+            x = x0 - 1;
+            break;
+        case EDIS_DELETE:
+            x = x0 - 1;
+            k --;
+            break;
+        case EDIS_INSERT:
+            k ++;
+            break;
+        }
+        assert (x == furthest[EDLV_IDX (e - 1, k)]);
+    }
+    if (num > 0) {
+        memmove (path, path + num, sizeof (char) * (lena + lenb - num));
+    }
+    *ret_numpath = lena + lenb - num;
+
+end_lv:
+    ed_lce_clear (&lce);
+    free (furthest);
+    free (stra);
+    free (strb);
+    return ret;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file    edmatrix.cpp
+ * @brief   The C interface of the matrices of the typed elements
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#include <new>
+
+#include "edmatrix.h"
+
+/**
+ * @brief the narrowest element type to hold the values in [minval, maxval]
+ *
+ * @param minval : the min value to be stored
+ * @param maxval : the max value to be stored
+ *
+ * @return EDMAT_BIT1, ..., EDMAT_INT32
+ *
+ * The packed types hold only the values >= 0, for example the directions EDIS_*, or a flag of each cell.
+ */
+int
+edmat_type_fit (int minval, int maxval)
+{
+    if (minval >= 0) {
+        if (maxval <= 1) {
+            return EDMAT_BIT1;
+        }
+        if (maxval <= 3) {
+            return EDMAT_BIT2;
+        }
+        if (maxval <= 15) {
+            return EDMAT_BIT4;
+        }
+    }
+    if ((minval >= INT8_MIN) && (maxval <= INT8_MAX)) {
+        return EDMAT_INT8;
+    }
+    if ((minval >= INT16_MIN) && (maxval <= INT16_MAX)) {
+        return EDMAT_INT16;
+    }
+    return EDMAT_INT32;
+}
+
+template <int TYPE>
+static ed_matrix_base *
+edmat_new (int layout)
+{
+    if (EDMAT_TILED == layout) {
+        return new (std::nothrow) ed_typed_matrix<typename ed_elem_of<TYPE>::type, true> (TYPE);
+    }
+    return new (std::nothrow) ed_typed_matrix<typename ed_elem_of<TYPE>::type, false> (TYPE);
+}
+
+/**
+ * @brief create an empty matrix
+ *
+ * @param type : the type of the elements, EDMAT_INT8, ..., see edmat_type_fit()
+ * @param layout : EDMAT_ROWS or EDMAT_TILED
+ *
+ * @return the userdata for edmat_resize(), edmat_get() and edmat_set(); NULL on error
+ *
+ * The userdata is freed by edmat_destroy().
+ */
+void *
+edmat_create (int type, int layout)
+{
+    ed_matrix_base *pm = NULL;
+
+    if ((EDMAT_ROWS != layout) && (EDMAT_TILED != layout)) {
+        return NULL;
+    }
+    switch (type) {
+    case EDMAT_INT8:
+        pm = edmat_new<EDMAT_INT8> (layout);
+        break;
+    case EDMAT_INT16:
+        pm = edmat_new<EDMAT_INT16> (layout);
+        break;
+    case EDMAT_INT32:
+        pm = edmat_new<EDMAT_INT32> (layout);
+        break;
+    case EDMAT_BIT1:
+        pm = edmat_new<EDMAT_BIT1> (layout);
+        break;
+    case EDMAT_BIT2:
+        pm = edmat_new<EDMAT_BIT2> (layout);
+        break;
+    case EDMAT_BIT4:
+        pm = edmat_new<EDMAT_BIT4> (layout);
+        break;
+    default:
+        break;
+    }
+    return pm;
+}
+
+void
+edmat_destroy (void *userdata)
+{
+    delete (ed_matrix_base *)userdata;
+}
+
+/* the size of the memory used by the matrix, in bytes */
+size_t
+edmat_memsize (void *userdata)
+{
+    assert (NULL != userdata);
+    return ((ed_matrix_base *)userdata)->vmemsize ();
+}
+
+/* the buffer of the elements and its size in bytes, such as for ed_numa_account(); NULL before edmat_resize() */
+const void *
+edmat_buffer (void *userdata, size_t *ret_size)
+{
+    assert (NULL != userdata);
+    assert (NULL != ret_size);
+    return ((ed_matrix_base *)userdata)->vbuffer (ret_size);
+}
+
+/* resize the matrix to (row, col), the elements are left uninitialized */
+int
+edmat_resize (void *userdata, size_t row, size_t col)
+{
+    assert (NULL != userdata);
+    return ((ed_matrix_base *)userdata)->vresize (row, col);
+}
+
+int
+edmat_get (void *userdata, size_t row, size_t col)
+{
+    assert (NULL != userdata);
+    return ((ed_matrix_base *)userdata)->vget (row, col);
+}
+
+/* the value is truncated to the type of the elements */
+int
+edmat_set (void *userdata, size_t row, size_t col, int val)
+{
+    assert (NULL != userdata);
+    ((ed_matrix_base *)userdata)->vset (row, col, val);
+    return 0;
+}
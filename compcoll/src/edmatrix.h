@@ -0,0 +1,192 @@
+/**
+ * @file    edmatrix.h
+ * @brief   The matrices of the typed elements, for the cb_mat* interface of the strcmp_t
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#ifndef __MY_EDMATRIX_H
+#define __MY_EDMATRIX_H
+
+#include <stdlib.h>    /* size_t */
+
+#include "mymat.h"     /* MYMAT_TILE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /*__cplusplus*/
+
+/* the type of the elements */
+#define EDMAT_INT8  0 /* int8_t */
+#define EDMAT_INT16 1 /* int16_t */
+#define EDMAT_INT32 2 /* int32_t */
+#define EDMAT_BIT1  3 /* 1 bit, the values in [0, 1] */
+#define EDMAT_BIT2  4 /* 2 bits, the values in [0, 3] */
+#define EDMAT_BIT4  5 /* 4 bits, the values in [0, 15] */
+
+/* the layout of the elements */
+#define EDMAT_ROWS  0 /* by the rows, each row starts at a cache line pointed by the row pointer */
+#define EDMAT_TILED 1 /* by the tiles of MYMAT_TILE x MYMAT_TILE, same as mymat_set_tiled() */
+
+#define EDMAT_ALIGN 64 /* the alignment of the buffer and the rows, in bytes */
+
+/*
+ * The matrix is created for one element type and never promoted as the compact mymatrix_t does,
+ * the caller picks the narrowest type by edmat_type_fit() from the range of the values it'll store.
+ * The kernels of edkernel.h access it directly if the cb_mat* of the strcmp_t are edmat_*;
+ * the directions of the kernels fit in EDMAT_BIT2, the EDIS_IGNORE is stored as EDIS_REPLAC.
+ * edmat_resize() does not clear the elements, as mymat_set_nozero(): the caller writes each one before reading it.
+ */
+int edmat_type_fit (int minval, int maxval);
+void * edmat_create (int type, int layout);
+void edmat_destroy (void *userdata);
+size_t edmat_memsize (void *userdata);
+const void * edmat_buffer (void *userdata, size_t *ret_size);
+int edmat_resize (void *userdata, size_t row, size_t col);
+int edmat_get (void *userdata, size_t row, size_t col);
+int edmat_set (void *userdata, size_t row, size_t col, int val);
+
+#ifdef __cplusplus
+}
+
+#include <stdint.h>
+#include <assert.h>
+
+/* 有符号整数元素 */
+template <typename T>
+struct ed_int_elem {
+    static size_t bytes (size_t num) { return sizeof (T) * num; }
+    static int get (const void *base, size_t idx) { return ((const T *)base)[idx]; }
+    static void set (void *base, size_t idx, int val) { ((T *)base)[idx] = (T)val; }
+};
+
+/* 每个元素 BITS 位的无符号整数, 打包在 64 bits 的字里, 元素不跨字 */
+template <unsigned int BITS>
+struct ed_bit_elem {
+    static size_t bytes (size_t num) { return (num * BITS + 63) / 64 * sizeof (uint64_t); }
+    static int get (const void *base, size_t idx) {
+        return (int)((((const uint64_t *)base)[idx * BITS / 64] >> (idx * BITS % 64)) & ((1U << BITS) - 1));
+    }
+    static void set (void *base, size_t idx, int val) {
+        uint64_t *w = ((uint64_t *)base) + idx * BITS / 64;
+        unsigned int shift = idx * BITS % 64;
+        *w = (*w & ~((uint64_t)((1U << BITS) - 1) << shift)) | ((uint64_t)(val & ((1U << BITS) - 1)) << shift);
+    }
+};
+
+/* EDMAT_* 对应的元素 */
+template <int TYPE> struct ed_elem_of;
+template <> struct ed_elem_of<EDMAT_INT8>  { typedef ed_int_elem<int8_t>  type; };
+template <> struct ed_elem_of<EDMAT_INT16> { typedef ed_int_elem<int16_t> type; };
+template <> struct ed_elem_of<EDMAT_INT32> { typedef ed_int_elem<int32_t> type; };
+template <> struct ed_elem_of<EDMAT_BIT1>  { typedef ed_bit_elem<1> type; };
+template <> struct ed_elem_of<EDMAT_BIT2>  { typedef ed_bit_elem<2> type; };
+template <> struct ed_elem_of<EDMAT_BIT4>  { typedef ed_bit_elem<4> type; };
+
+/* edmat_create() 返回的对象, C 接口 edmat_* 通过虚函数访问 */
+struct ed_matrix_base {
+    int type;   /* EDMAT_INT8, ... */
+    int layout; /* EDMAT_ROWS or EDMAT_TILED */
+    ed_matrix_base (int t, int l) : type(t), layout(l) {}
+    virtual ~ed_matrix_base () {}
+    virtual int vresize (size_t row, size_t col) = 0;
+    virtual int vget (size_t row, size_t col) const = 0;
+    virtual void vset (size_t row, size_t col, int val) = 0;
+    virtual size_t vmemsize () const = 0;
+    virtual const void * vbuffer (size_t *ret_size) const = 0;
+};
+
+/**
+ * 元素为 Elem 的矩阵; TILED 为 false 时按行存储, 每行的起点由行指针给出并对齐到缓存行,
+ * TILED 为 true 时按 MYMAT_TILE x MYMAT_TILE 的块存储, 块内的下标同 mymat_index_tiled()。
+ * resize/get/set 不是虚函数，kernel 用具体的类型访问时可以被内联。
+ */
+template <typename Elem, bool TILED = false>
+struct ed_typed_matrix : public ed_matrix_base {
+    void *buf;
+    char **rows;      /* the row pointers, EDMAT_ROWS */
+    size_t szmem;     /* the size of buf in bytes */
+    size_t numrows;   /* the # of the row pointers allocated */
+    size_t sztilerow; /* the # of elements in a row of tiles, EDMAT_TILED */
+
+    explicit ed_typed_matrix (int t) : ed_matrix_base(t, TILED?EDMAT_TILED:EDMAT_ROWS), buf(NULL), rows(NULL), szmem(0), numrows(0), sztilerow(0) {}
+    virtual ~ed_typed_matrix () { free (rows); free (buf); }
+
+    /* resize the matrix to (row, col); the elements are not cleared, the kernels write each one before reading it */
+    int resize (size_t row, size_t col) {
+        size_t szrow = 0;
+        size_t sz;
+        size_t i;
+        if (TILED) {
+            sztilerow = ((col + MYMAT_TILE_MASK) >> MYMAT_TILE_BITS) << (2 * MYMAT_TILE_BITS);
+            sz = Elem::bytes (((row + MYMAT_TILE_MASK) >> MYMAT_TILE_BITS) * sztilerow);
+        } else {
+            szrow = (Elem::bytes (col) + EDMAT_ALIGN - 1) & ~((size_t)EDMAT_ALIGN - 1);
+            sz = szrow * row;
+            if (row > numrows) {
+                char **newrows = (char **)realloc (rows, sizeof (char *) * row);
+                if (NULL == newrows) {
+                    return -1;
+                }
+                rows = newrows;
+                numrows = row;
+            }
+        }
+        if (sz > szmem) {
+            free (buf);
+            szmem = 0;
+            if (0 != posix_memalign (&buf, EDMAT_ALIGN, sz)) {
+                buf = NULL;
+                return -1;
+            }
+            szmem = sz;
+        }
+        if (! TILED) {
+            for (i = 0; i < row; i ++) {
+                rows[i] = (char *)buf + i * szrow;
+            }
+        }
+        return 0;
+    }
+    int get (size_t row, size_t col) const {
+        if (TILED) {
+            return Elem::get (buf, (row >> MYMAT_TILE_BITS) * sztilerow + ((col >> MYMAT_TILE_BITS) << (2 * MYMAT_TILE_BITS))
+                + ((row & MYMAT_TILE_MASK) << MYMAT_TILE_BITS) + (col & MYMAT_TILE_MASK));
+        }
+        return Elem::get (rows[row], col);
+    }
+    void set (size_t row, size_t col, int val) {
+        if (TILED) {
+            Elem::set (buf, (row >> MYMAT_TILE_BITS) * sztilerow + ((col >> MYMAT_TILE_BITS) << (2 * MYMAT_TILE_BITS))
+                + ((row & MYMAT_TILE_MASK) << MYMAT_TILE_BITS) + (col & MYMAT_TILE_MASK), val);
+            return;
+        }
+        Elem::set (rows[row], col, val);
+    }
+
+    virtual int vresize (size_t row, size_t col) { return resize (row, col); }
+    virtual int vget (size_t row, size_t col) const { return get (row, col); }
+    virtual void vset (size_t row, size_t col, int val) { set (row, col, val); }
+    virtual size_t vmemsize () const { return szmem + sizeof (char *) * numrows; }
+    virtual const void * vbuffer (size_t *ret_size) const { *ret_size = szmem; return buf; }
+
+private:
+    ed_typed_matrix (const ed_typed_matrix &);
+    ed_typed_matrix & operator= (const ed_typed_matrix &);
+};
+
+/* edmat_create() 返回的 userdata 作为具体的类型, 类型和布局必须是 TYPE 和 TILED */
+template <int TYPE, bool TILED>
+static inline ed_typed_matrix<typename ed_elem_of<TYPE>::type, TILED> &
+edmat_cast (void *userdata)
+{
+    ed_matrix_base *pm = (ed_matrix_base *)userdata;
+    assert (TYPE == pm->type);
+    assert ((TILED?EDMAT_TILED:EDMAT_ROWS) == pm->layout);
+    return *static_cast<ed_typed_matrix<typename ed_elem_of<TYPE>::type, TILED> *>(pm);
+}
+
+#endif /*__cplusplus*/
+#endif /* __MY_EDMATRIX_H */
@@ -0,0 +1,251 @@
+/**
+ * @file    edmyers.c
+ * @brief   The O(ND) difference algorithm by E. W. Myers, linear space version
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "editdistance.h"
+
+#ifndef DEBUG
+#define DEBUG 0
+#endif
+
+#if DEBUG
+#define TRACE(fmt, ...) fprintf(stderr, fmt, ##__VA_ARGS__)
+#else
+#define TRACE(...)
+#endif
+
+typedef struct _ed_myers_t {
+    const wchar_t *stra;
+    const wchar_t *strb;
+    int *v1;        /* furthest reaching x of the forward paths, indexed by the diagonal k = x - y */
+    int *v2;        /* furthest reaching x of the reverse paths */
+    char *path;
+    size_t numpath; /* the number of items filled in path */
+    int dist;
+} ed_myers_t;
+
+static void
+ed_myers_append (ed_myers_t *pm, char action, size_t num)
+{
+    for (; num > 0; num --) {
+        pm->path[pm->numpath ++] = action;
+        if (EDIS_IGNORE != action) {
+            pm->dist ++;
+        }
+    }
+}
+
+/**
+ * @brief 找出 a[a0..a1) 和 b[b0..b1) 的最优路径所经过的中间点
+ *
+ * 同时从左上角正向和从右下角反向地扩展各对角线上最远的 d-path，两者在同一对角线上相遇时，
+ * 相遇点就在一条最优路径上。此时两边各只用了约 D/2 步。
+ *
+ * @return 0 -- 找到 (*ret_x, *ret_y)，相对于 (a0, b0); -1 -- 两者没有公共字符
+ */
+static int
+ed_myers_bisect (ed_myers_t *pm, int a0, int a1, int b0, int b1, int *ret_x, int *ret_y)
+{
+    const wchar_t *a = pm->stra + a0;
+    const wchar_t *b = pm->strb + b0;
+    int lena = a1 - a0;
+    int lenb = b1 - b0;
+    int maxd = (lena + lenb + 1) / 2;
+    int voff = maxd;
+    int vlen = 2 * maxd;
+    int delta = lena - lenb;
+    int front = (delta % 2 != 0); /* 奇数时正向路径检查相遇，偶数时反向路径检查 */
+    int k1start = 0;
+    int k1end = 0;
+    int k2start = 0;
+    int k2end = 0;
+    int d;
+    int k1;
+    int k2;
+    int x1;
+    int y1;
+    int x2;
+    int y2;
+    int koff;
+
+    for (d = 0; d < vlen + 2; d ++) {
+        pm->v1[d] = -1;
+        pm->v2[d] = -1;
+    }
+    pm->v1[voff + 1] = 0;
+    pm->v2[voff + 1] = 0;
+    for (d = 0; d < maxd; d ++) {
+        /* 正向 */
+        for (k1 = -d + k1start; k1 <= d - k1end; k1 += 2) {
+            koff = voff + k1;
+            if (k1 == -d || (k1 != d && pm->v1[koff - 1] < pm->v1[koff + 1])) {
+                x1 = pm->v1[koff + 1];
+            } else {
+                x1 = pm->v1[koff - 1] + 1;
+            }
+            y1 = x1 - k1;
+            while (x1 < lena && y1 < lenb && a[x1] == b[y1]) {
+                x1 ++;
+                y1 ++;
+            }
+            pm->v1[koff] = x1;
+            if (x1 > lena) {
+                /* 越过了右边界 */
+                k1end += 2;
+            } else if (y1 > lenb) {
+                /* 越过了下边界 */
+                k1start += 2;
+            } else if (front) {
+                koff = voff + delta - k1;
+                if (koff >= 0 && koff < vlen && pm->v2[koff] != -1) {
+                    x2 = lena - pm->v2[koff];
+                    if (x1 >= x2) {
+                        *ret_x = x1;
+                        *ret_y = y1;
+                        return 0;
+                    }
+                }
+            }
+        }
+        /* 反向 */
+        for (k2 = -d + k2start; k2 <= d - k2end; k2 += 2) {
+            koff = voff + k2;
+            if (k2 == -d || (k2 != d && pm->v2[koff - 1] < pm->v2[koff + 1])) {
+                x2 = pm->v2[koff + 1];
+            } else {
+                x2 = pm->v2[koff - 1] + 1;
+            }
+            y2 = x2 - k2;
+            while (x2 < lena && y2 < lenb && a[lena - x2 - 1] == b[lenb - y2 - 1]) {
+                x2 ++;
+                y2 ++;
+            }
+            pm->v2[koff] = x2;
+            if (x2 > lena) {
+                k2end += 2;
+            } else if (y2 > lenb) {
+                k2start += 2;
+            } else if (! front) {
+                koff = voff + delta - k2;
+                if (koff >= 0 && koff < vlen && pm->v1[koff] != -1) {
+                    x1 = pm->v1[koff];
+                    y1 = voff + x1 - koff;
+                    if (x1 >= lena - x2) {
+                        *ret_x = x1;
+                        *ret_y = y1;
+                        return 0;
+                    }
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+/* 对 a[a0..a1) 和 b[b0..b1) 做分治 */
+static void
+ed_myers_recursive (ed_myers_t *pm, int a0, int a1, int b0, int b1)
+{
+    int x;
+    int y;
+    int numsuffix = 0;
+
+    /* 去掉相同的头和尾 */
+    while (a0 < a1 && b0 < b1 && pm->stra[a0] == pm->strb[b0]) {
+        ed_myers_append (pm, EDIS_IGNORE, 1);
+        a0 ++;
+        b0 ++;
+    }
+    while (a0 < a1 && b0 < b1 && pm->stra[a1 - 1] == pm->strb[b1 - 1]) {
+        numsuffix ++;
+        a1 --;
+        b1 --;
+    }
+
+    if (a0 >= a1) {
+        ed_myers_append (pm, EDIS_INSERT, b1 - b0);
+    } else if (b0 >= b1) {
+        ed_myers_append (pm, EDIS_DELETE, a1 - a0);
+    } else if (0 == ed_myers_bisect (pm, a0, a1, b0, b1, &x, &y)) {
+        TRACE ("bisect (%d,%d)-(%d,%d) at (%d,%d)\n", a0, b0, a1, b1, a0 + x, b0 + y);
+        ed_myers_recursive (pm, a0, a0 + x, b0, b0 + y);
+        ed_myers_recursive (pm, a0 + x, a1, b0 + y, b1);
+    } else {
+        /* 没有相遇, 说明两者没有任何相同的字符 */
+        ed_myers_append (pm, EDIS_DELETE, a1 - a0);
+        ed_myers_append (pm, EDIS_INSERT, b1 - b0);
+    }
+    ed_myers_append (pm, EDIS_IGNORE, numsuffix);
+}
+
+/**
+ * @brief 计算两个字符串的差异和修改路径, Myers O(ND) 算法
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回插入和删除的总个数, 失败返回 -1
+ *
+ * 本函数只使用插入和删除(EDIS_INSERT, EDIS_DELETE, EDIS_IGNORE)，即最长公共子序列意义下的最小修改，
+ * 所以一个替换在这里算作一个删除加一个插入。时间O((m+n)*D), 空间O(m+n)，D 为差异的个数。
+ * 对于几乎相同的两个文本，要比 ed_edit_distance_path() 快很多。
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_myers (strcmp_t *cmpinfo, char *path, size_t *ret_numpath)
+{
+    ed_myers_t myers;
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    int maxd;
+    int ret = -1;
+
+    assert (NULL != cmpinfo);
+    assert (NULL != path);
+    assert (NULL != ret_numpath);
+
+    memset (&myers, 0, sizeof (myers));
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL == stra) || (NULL == strb)) {
+        goto end_myers;
+    }
+    maxd = (lena + lenb + 1) / 2;
+    myers.v1 = (int *)malloc (sizeof (int) * (2 * maxd + 2) * 2);
+    if (NULL == myers.v1) {
+        goto end_myers;
+    }
+    myers.v2 = myers.v1 + (2 * maxd + 2);
+    myers.stra = stra;
+    myers.strb = strb;
+    myers.path = path;
+
+    ed_myers_recursive (&myers, 0, lena, 0, lenb);
+    assert (myers.numpath <= lena + lenb);
+    *ret_numpath = myers.numpath;
+    ret = myers.dist;
+
+end_myers:
+    if (NULL != myers.v1) {
+        free (myers.v1);
+    }
+    if (NULL != stra) {
+        free (stra);
+    }
+    if (NULL != strb) {
+        free (strb);
+    }
+    return ret;
+}
@@ -0,0 +1,526 @@
+/**
+ * @file    ednuma.c
+ * @brief   NUMA placement of the worker threads and the large buffers, by the syscalls without libnuma
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#define _GNU_SOURCE 1
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h> /* sysconf(), syscall() */
+#include <sched.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+
+#include "ednuma.h"
+
+#define EDNUMA_MAXNODE 64    /* the nodes supported, the bits of the node mask */
+#define EDNUMA_MAXPIN  256   /* the workers recorded for the report */
+#define EDNUMA_MAXACCT 8     /* the buffers recorded for the report */
+#define EDNUMA_SAMPLES 1024  /* the pages sampled to find the placement of a buffer */
+#define EDNUMA_MPOL_INTERLEAVE 3 /* MPOL_INTERLEAVE of <numaif.h> */
+
+#define EDNUMA_SYSNODE "/sys/devices/system/node"
+
+/* the placement of the sampled pages of a buffer */
+typedef struct _ednuma_acct_t {
+    const char *name;
+    size_t size;
+    size_t numpages[EDNUMA_MAXNODE + 1]; /* the pages on each node, [EDNUMA_MAXNODE] -- not touched yet */
+} ednuma_acct_t;
+
+static pthread_once_t g_numa_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t g_numa_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_numa_numnodes = 1;        /* the nodes online */
+static int g_numa_cpunode[CPU_SETSIZE]; /* the node of each CPU */
+static cpu_set_t g_numa_allowed;       /* the affinity of the process when initialized */
+static int g_numa_order[CPU_SETSIZE];  /* the allowed CPUs, of the node of the main thread first, then the other nodes */
+static int g_numa_numorder = 0;
+static int g_numa_numspan = 1;         /* the nodes of the allowed CPUs */
+static int g_numa_pinmode = EDNUMA_PIN_AUTO;
+static char g_numa_flg_report = 0;
+static int g_numa_pincpu[EDNUMA_MAXPIN]; /* the CPU of each worker pinned, -1 -- not pinned */
+static int g_numa_numpin = 0;
+static ednuma_acct_t g_numa_acct[EDNUMA_MAXACCT];
+static int g_numa_numacct = 0;
+static int g_numa_numbindfail = 0;     /* the buffers of ed_numa_alloc() that mbind() failed to interleave */
+
+/* read the small file of the sysfs, return 0 on success */
+static int
+ednuma_read (const char *filename, char *buf, size_t szbuf)
+{
+    FILE *fp;
+    size_t sz;
+
+    fp = fopen (filename, "r");
+    if (NULL == fp) {
+        return -1;
+    }
+    sz = fread (buf, 1, szbuf - 1, fp);
+    fclose (fp);
+    buf[sz] = 0;
+    return ((sz > 0)?0:-1);
+}
+
+/* parse the list such as "0-3,8,10-11", set the flags of the numbers in [0, max) */
+static void
+ednuma_parse_list (const char *str, char *flags, int max)
+{
+    char *end;
+    long first;
+    long last;
+
+    while (('0' <= *str) && (*str <= '9')) {
+        first = strtol (str, &end, 10);
+        last = first;
+        if ('-' == *end) {
+            last = strtol (end + 1, &end, 10);
+        }
+        for (; first <= last; first ++) {
+            if ((first >= 0) && (first < max)) {
+                flags[first] = 1;
+            }
+        }
+        str = end;
+        if (',' == *str) {
+            str ++;
+        }
+    }
+}
+
+static int
+ednuma_node_of (int cpu)
+{
+    return ((g_numa_cpunode[cpu] < 0)?0:g_numa_cpunode[cpu]);
+}
+
+/* read the topology and the affinity of the process */
+static void
+ednuma_init (void)
+{
+    char buf[4096];
+    char filename[sizeof (EDNUMA_SYSNODE) + 32];
+    char nodes[EDNUMA_MAXNODE];
+    char cpus[CPU_SETSIZE];
+    char span[EDNUMA_MAXNODE];
+    int home;
+    int pass;
+    int n;
+    int c;
+
+    for (c = 0; c < CPU_SETSIZE; c ++) {
+        g_numa_cpunode[c] = -1;
+    }
+    memset (nodes, 0, sizeof (nodes));
+    if (0 == ednuma_read (EDNUMA_SYSNODE "/online", buf, sizeof (buf))) {
+        ednuma_parse_list (buf, nodes, EDNUMA_MAXNODE);
+    } else {
+        /* no NUMA in the kernel, all the CPUs are on the node 0 */
+        nodes[0] = 1;
+    }
+    g_numa_numnodes = 0;
+    for (n = 0; n < EDNUMA_MAXNODE; n ++) {
+        if (! nodes[n]) {
+            continue;
+        }
+        g_numa_numnodes ++;
+        snprintf (filename, sizeof (filename), EDNUMA_SYSNODE "/node%d/cpulist", n);
+        if (0 != ednuma_read (filename, buf, sizeof (buf))) {
+            continue;
+        }
+        memset (cpus, 0, sizeof (cpus));
+        ednuma_parse_list (buf, cpus, CPU_SETSIZE);
+        for (c = 0; c < CPU_SETSIZE; c ++) {
+            if (cpus[c]) {
+                g_numa_cpunode[c] = n;
+            }
+        }
+    }
+    if (0 != sched_getaffinity (0, sizeof (g_numa_allowed), &g_numa_allowed)) {
+        CPU_ZERO (&g_numa_allowed);
+        for (c = 0; (c < CPU_SETSIZE) && (c < sysconf (_SC_NPROCESSORS_ONLN)); c ++) {
+            CPU_SET (c, &g_numa_allowed);
+        }
+    }
+
+    /* the workers fill the node of the main thread first, it allocates the buffers */
+    c = sched_getcpu ();
+    home = (((c >= 0) && (c < CPU_SETSIZE))?ednuma_node_of (c):0);
+    memset (span, 0, sizeof (span));
+    g_numa_numorder = 0;
+    for (pass = -1; pass < EDNUMA_MAXNODE; pass ++) {
+        n = ((pass < 0)?home:pass);
+        if ((pass >= 0) && (n == home)) {
+            continue;
+        }
+        for (c = 0; c < CPU_SETSIZE; c ++) {
+            if (CPU_ISSET (c, &g_numa_allowed) && (n == ednuma_node_of (c))) {
+                g_numa_order[g_numa_numorder ++] = c;
+                span[n] = 1;
+            }
+        }
+    }
+    g_numa_numspan = 0;
+    for (n = 0; n < EDNUMA_MAXNODE; n ++) {
+        g_numa_numspan += span[n];
+    }
+    for (c = 0; c < EDNUMA_MAXPIN; c ++) {
+        g_numa_pincpu[c] = -1;
+    }
+}
+
+static int
+ednuma_pinning (void)
+{
+    pthread_once (&g_numa_once, ednuma_init);
+    if (g_numa_numorder < 1) {
+        return 0;
+    }
+    switch (g_numa_pinmode) {
+    case EDNUMA_PIN_ON:
+        return 1;
+    case EDNUMA_PIN_OFF:
+        return 0;
+    }
+    return (g_numa_numspan > 1);
+}
+
+/**
+ * @brief set when ed_numa_pin_worker() pins the threads
+ *
+ * @param mode : EDNUMA_PIN_AUTO, EDNUMA_PIN_ON or EDNUMA_PIN_OFF
+ *
+ * @return 0 on success, -1 on error
+ *
+ * The CPUs of a single node are shared by the other processes on the same machine, pinning them only adds
+ * the contention, so by default the workers are pinned only on the machines of multiple nodes.
+ */
+int
+ed_numa_set_pin (int mode)
+{
+    if ((EDNUMA_PIN_AUTO != mode) && (EDNUMA_PIN_ON != mode) && (EDNUMA_PIN_OFF != mode)) {
+        return -1;
+    }
+    g_numa_pinmode = mode;
+    return 0;
+}
+
+/* record the pinning and the placement of the buffers for ed_numa_report() */
+int
+ed_numa_set_report (char flg_report)
+{
+    g_numa_flg_report = flg_report;
+    return 0;
+}
+
+/* the number of the nodes online */
+int
+ed_numa_num_nodes (void)
+{
+    pthread_once (&g_numa_once, ednuma_init);
+    return g_numa_numnodes;
+}
+
+/**
+ * @brief pin the calling thread, the worker idx of a multi-threaded alignment, to one CPU
+ *
+ * @param idx : the index of the worker, from 0
+ *
+ * @return the CPU, -1 if not pinned
+ *
+ * The workers take the allowed CPUs of the node of the main thread first, so the buffers it allocated are local
+ * to as many workers as possible; the buffers allocated by a worker are touched first and placed by itself.
+ */
+int
+ed_numa_pin_worker (int idx)
+{
+    cpu_set_t set;
+    int cpu;
+
+    assert (idx >= 0);
+    if (! ednuma_pinning ()) {
+        return -1;
+    }
+    cpu = g_numa_order[idx % g_numa_numorder];
+    CPU_ZERO (&set);
+    CPU_SET (cpu, &set);
+    if (0 != pthread_setaffinity_np (pthread_self (), sizeof (set), &set)) {
+        return -1;
+    }
+    if (g_numa_flg_report && (idx < EDNUMA_MAXPIN)) {
+        pthread_mutex_lock (&g_numa_lock);
+        g_numa_pincpu[idx] = cpu;
+        if (idx >= g_numa_numpin) {
+            g_numa_numpin = idx + 1;
+        }
+        pthread_mutex_unlock (&g_numa_lock);
+    }
+    return cpu;
+}
+
+/* restore the affinity of the calling thread, for the main thread after the workers are done */
+int
+ed_numa_unpin (void)
+{
+    if (! ednuma_pinning ()) {
+        return 0;
+    }
+    return ((0 == pthread_setaffinity_np (pthread_self (), sizeof (g_numa_allowed), &g_numa_allowed))?0:-1);
+}
+
+/**
+ * @brief spread the pages of the buffer shared by the workers over their nodes
+ *
+ * @param buf : the buffer, page aligned and not touched yet, such as by ed_numa_alloc()
+ * @param len : the size of the buffer in bytes
+ * @param nworkers : the number of the workers, pinned by ed_numa_pin_worker()
+ *
+ * @return 0 on success or nothing to do, -1 on error
+ *
+ * Each page of the buffer may be written by any worker, so the first touch would place it by the chance;
+ * interleaved by mbind(), the bandwidth of all the nodes of the workers is used. Nothing is done if the
+ * workers are not pinned or they are on one node, then the pages are placed by the first touch.
+ * The policy applies to the whole pages only: an unaligned buffer, such as by malloc(), shares its pages
+ * with the other allocations that may be touched already, so it's rejected.
+ */
+int
+ed_numa_interleave (void *buf, size_t len, int nworkers)
+{
+#ifdef SYS_mbind
+    unsigned long mask[(EDNUMA_MAXNODE + 8 * sizeof (unsigned long) - 1) / (8 * sizeof (unsigned long))];
+    uintptr_t pgsz = sysconf (_SC_PAGESIZE);
+    uintptr_t start;
+    uintptr_t end;
+    int numnodes = 0;
+    int node;
+    int i;
+
+    if ((NULL == buf) || (len < 1) || (nworkers < 2) || (! ednuma_pinning ())) {
+        return 0;
+    }
+    if (0 != ((uintptr_t)buf & (pgsz - 1))) {
+        return -1;
+    }
+    memset (mask, 0, sizeof (mask));
+    for (i = 0; (i < nworkers) && (i < g_numa_numorder); i ++) {
+        node = ednuma_node_of (g_numa_order[i]);
+        if (0 == (mask[node / (8 * sizeof (unsigned long))] & (1UL << (node % (8 * sizeof (unsigned long)))))) {
+            mask[node / (8 * sizeof (unsigned long))] |= (1UL << (node % (8 * sizeof (unsigned long))));
+            numnodes ++;
+        }
+    }
+    if (numnodes < 2) {
+        return 0;
+    }
+    start = (uintptr_t)buf;
+    end = ((uintptr_t)buf + len + pgsz - 1) & ~(pgsz - 1);
+    /* the kernel reads maxnode - 1 bits of the mask */
+    if (0 != syscall (SYS_mbind, start, end - start, EDNUMA_MPOL_INTERLEAVE, mask, EDNUMA_MAXNODE + 1, 0)) {
+        return -1;
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief allocate the buffer shared by the workers, interleaved over their nodes by ed_numa_interleave()
+ *
+ * @param len : the size of the buffer in bytes
+ * @param nworkers : the number of the workers, pinned by ed_numa_pin_worker()
+ *
+ * @return the buffer, zero-filled; NULL on error. Freed by ed_numa_free().
+ *
+ * The buffer is mapped by mmap(), so its pages are its own and not touched yet when mbind() sets the policy.
+ * If mbind() fails the buffer is still returned, the pages are placed by the first touch; the failure is
+ * counted in ed_numa_report().
+ */
+void *
+ed_numa_alloc (size_t len, int nworkers)
+{
+    void *buf;
+
+    if (len < 1) {
+        len = 1;
+    }
+    buf = mmap (NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == buf) {
+        return NULL;
+    }
+    if (ed_numa_interleave (buf, len, nworkers) < 0) {
+        pthread_mutex_lock (&g_numa_lock);
+        g_numa_numbindfail ++;
+        pthread_mutex_unlock (&g_numa_lock);
+    }
+    return buf;
+}
+
+/* free the buffer of ed_numa_alloc() of len bytes */
+void
+ed_numa_free (void *buf, size_t len)
+{
+    if (NULL == buf) {
+        return;
+    }
+    munmap (buf, (len < 1)?1:len);
+}
+
+/**
+ * @brief record the nodes of the pages of the buffer for ed_numa_report(), if ed_numa_set_report() is set
+ *
+ * @param name : the name of the buffer in the report, a constant string
+ * @param buf : the buffer, after it's filled
+ * @param len : the size of the buffer in bytes
+ *
+ * Up to EDNUMA_SAMPLES pages are queried by move_pages() without moving them.
+ */
+void
+ed_numa_account (const char *name, const void *buf, size_t len)
+{
+#ifdef SYS_move_pages
+    void *pages[EDNUMA_SAMPLES];
+    int status[EDNUMA_SAMPLES];
+    uintptr_t pgsz = sysconf (_SC_PAGESIZE);
+    uintptr_t start;
+    size_t numpages;
+    size_t num;
+    size_t i;
+    ednuma_acct_t *pa = NULL;
+    long ret;
+    int k;
+
+    if ((! g_numa_flg_report) || (NULL == buf) || (len < 1)) {
+        return;
+    }
+    start = ((uintptr_t)buf) & ~(pgsz - 1);
+    numpages = (((uintptr_t)buf + len + pgsz - 1) & ~(pgsz - 1)) - start;
+    numpages /= pgsz;
+    num = ((numpages < EDNUMA_SAMPLES)?numpages:EDNUMA_SAMPLES);
+    for (i = 0; i < num; i ++) {
+        pages[i] = (void *)(start + (i * numpages / num) * pgsz);
+        status[i] = -1;
+    }
+    ret = syscall (SYS_move_pages, 0, num, pages, NULL, status, 0);
+
+    pthread_mutex_lock (&g_numa_lock);
+    for (k = 0; k < g_numa_numacct; k ++) {
+        if (0 == strcmp (g_numa_acct[k].name, name)) {
+            pa = g_numa_acct + k;
+            break;
+        }
+    }
+    if ((NULL == pa) && (g_numa_numacct < EDNUMA_MAXACCT)) {
+        pa = g_numa_acct + g_numa_numacct ++;
+    }
+    if (NULL != pa) {
+        memset (pa, 0, sizeof (*pa));
+        pa->name = name;
+        pa->size = len;
+        for (i = 0; i < num; i ++) {
+            if ((0 == ret) && (status[i] >= 0) && (status[i] < EDNUMA_MAXNODE)) {
+                pa->numpages[status[i]] ++;
+            } else {
+                pa->numpages[EDNUMA_MAXNODE] ++;
+            }
+        }
+    }
+    pthread_mutex_unlock (&g_numa_lock);
+#endif
+}
+
+/* print the set of the CPUs such as "0-3,8" */
+static void
+ednuma_print_cpus (FILE *fp, int node)
+{
+    int c;
+    int first = -1;
+    int cnt = 0;
+
+    for (c = 0; c <= CPU_SETSIZE; c ++) {
+        if ((c < CPU_SETSIZE) && (node == g_numa_cpunode[c])) {
+            if (first < 0) {
+                first = c;
+            }
+            continue;
+        }
+        if (first >= 0) {
+            fprintf (fp, "%s%d", (cnt > 0)?",":"", first);
+            if (c - 1 > first) {
+                fprintf (fp, "-%d", c - 1);
+            }
+            cnt ++;
+            first = -1;
+        }
+    }
+    if (0 == cnt) {
+        fprintf (fp, "none");
+    }
+}
+
+/**
+ * @brief print the topology, the pinning of the workers and the placement of the buffers recorded
+ *
+ * @param fp : the output, such as stderr
+ */
+void
+ed_numa_report (FILE *fp)
+{
+    const ednuma_acct_t *pa;
+    size_t total;
+    int n;
+    int k;
+
+    pthread_once (&g_numa_once, ednuma_init);
+    fprintf (fp, "numa: %d node(s)", g_numa_numnodes);
+    for (n = 0; n < EDNUMA_MAXNODE; n ++) {
+        for (k = 0; (k < CPU_SETSIZE) && (n != g_numa_cpunode[k]); k ++);
+        if (k < CPU_SETSIZE) {
+            fprintf (fp, ", node %d: cpus ", n);
+            ednuma_print_cpus (fp, n);
+        }
+    }
+    fprintf (fp, "; the allowed CPUs are on %d node(s)\n", g_numa_numspan);
+
+    pthread_mutex_lock (&g_numa_lock);
+    if (g_numa_numpin > 0) {
+        fprintf (fp, "numa: workers pinned:");
+        for (k = 0; k < g_numa_numpin; k ++) {
+            if (g_numa_pincpu[k] >= 0) {
+                fprintf (fp, " %d->cpu%d(node %d)", k, g_numa_pincpu[k], ednuma_node_of (g_numa_pincpu[k]));
+            }
+        }
+        fprintf (fp, "\n");
+    } else {
+        fprintf (fp, "numa: workers not pinned%s\n", ((EDNUMA_PIN_AUTO == g_numa_pinmode) && (g_numa_numspan < 2))?", the allowed CPUs are on one node":"");
+    }
+    if (g_numa_numbindfail > 0) {
+        fprintf (fp, "numa: mbind() failed for %d shared buffer(s), placed by the first touch\n", g_numa_numbindfail);
+    }
+    for (k = 0; k < g_numa_numacct; k ++) {
+        pa = g_numa_acct + k;
+        for (total = 0, n = 0; n <= EDNUMA_MAXNODE; n ++) {
+            total += pa->numpages[n];
+        }
+        if (total < 1) {
+            continue;
+        }
+        fprintf (fp, "numa: %s, %zu KiB:", pa->name, pa->size >> 10);
+        for (n = 0; n < EDNUMA_MAXNODE; n ++) {
+            if (pa->numpages[n] > 0) {
+                fprintf (fp, " node %d %zu%%", n, pa->numpages[n] * 100 / total);
+            }
+        }
+        if (pa->numpages[EDNUMA_MAXNODE] > 0) {
+            fprintf (fp, " untouched %zu%%", pa->numpages[EDNUMA_MAXNODE] * 100 / total);
+        }
+        fprintf (fp, "\n");
+    }
+    pthread_mutex_unlock (&g_numa_lock);
+}
@@ -0,0 +1,39 @@
+/**
+ * @file    ednuma.h
+ * @brief   NUMA placement of the worker threads and the large buffers, by the syscalls without libnuma
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#ifndef __MY_EDNUMA_H
+#define __MY_EDNUMA_H
+
+#include <stdio.h>     /* FILE */
+#include <stdlib.h>    /* size_t */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /*__cplusplus*/
+
+/* the value of ed_numa_set_pin() */
+#define EDNUMA_PIN_AUTO 0 /* pin the workers only if the allowed CPUs are on more than one node (default) */
+#define EDNUMA_PIN_ON   1 /* always pin the workers */
+#define EDNUMA_PIN_OFF  2 /* never pin the workers */
+
+int ed_numa_set_pin (int mode);
+int ed_numa_set_report (char flg_report);
+int ed_numa_num_nodes (void);
+int ed_numa_pin_worker (int idx);
+int ed_numa_unpin (void);
+int ed_numa_interleave (void *buf, size_t len, int nworkers);
+void * ed_numa_alloc (size_t len, int nworkers);
+void ed_numa_free (void *buf, size_t len);
+void ed_numa_account (const char *name, const void *buf, size_t len);
+void ed_numa_report (FILE *fp);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif /* __MY_EDNUMA_H */
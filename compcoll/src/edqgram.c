@@ -0,0 +1,135 @@
+/**
+ * @file    edqgram.c
+ * @brief   The lower bound of the edit distance by the q-gram lemma (E. Ukkonen 1992)
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "editdistance.h"
+
+#define EDQGRAM_HASHBASE 1000003ULL
+
+/**
+ * q-gram 引理: 每一次编辑操作最多改变 q 个 q-gram(长度为 q 的子串)，
+ * 所以两个字符串 q-gram 计数的差(L1 距离) dq 满足 dq <= 2 * q * D，即 D >= dq / (2q)。
+ * q-gram 用哈希值表示，两个不同的 q-gram 哈希值相同只会使 dq 变小，下界仍然成立。
+ */
+
+static int
+ed_qgram_cmp (const void *a, const void *b)
+{
+    uint64_t ha = *(const uint64_t *)a;
+    uint64_t hb = *(const uint64_t *)b;
+    return (ha < hb)?-1:((ha > hb)?1:0);
+}
+
+/* 所有 q-gram 的哈希值, 排好序 */
+static uint64_t *
+ed_qgram_profile (const wchar_t *str, size_t len, size_t q, size_t *ret_num)
+{
+    uint64_t *hash;
+    uint64_t pw = 1;
+    uint64_t h = 0;
+    size_t num;
+    size_t i;
+
+    assert (len >= q);
+    num = len - q + 1;
+    hash = (uint64_t *)malloc (sizeof (uint64_t) * num);
+    if (NULL == hash) {
+        return NULL;
+    }
+    for (i = 1; i < q; i ++) {
+        pw *= EDQGRAM_HASHBASE;
+    }
+    /* rolling hash */
+    for (i = 0; i < len; i ++) {
+        if (i >= q) {
+            h -= pw * (uint64_t)str[i - q];
+        }
+        h = h * EDQGRAM_HASHBASE + (uint64_t)str[i];
+        if (i + 1 >= q) {
+            hash[i + 1 - q] = h;
+        }
+    }
+    qsort (hash, num, sizeof (uint64_t), ed_qgram_cmp);
+    *ret_num = num;
+    return hash;
+}
+
+/**
+ * @brief 用 q-gram 引理求编辑距离的下界
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ * @param q : q-gram 的长度, >= 1
+ *
+ * @return 返回距离的下界, 失败返回 -1
+ *
+ * 不做 DP, 时间O((m+n)log(m+n)), 空间O(m+n)。结果不超过 ed_edit_distance()，
+ * 并且不小于两个字符串的长度差。用于在 DP 之前排除差别很大的两个字符串。
+ */
+int
+ed_qgram_lower_bound (strcmp_t *cmpinfo, size_t q)
+{
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    uint64_t *hasha = NULL;
+    uint64_t *hashb = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    size_t numa = 0;
+    size_t numb = 0;
+    size_t ia;
+    size_t ib;
+    size_t same;
+    size_t dq;
+    int ret = -1;
+
+    assert (NULL != cmpinfo);
+    assert (q > 0);
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL == stra) || (NULL == strb)) {
+        goto end_qgram;
+    }
+    ret = (lena > lenb)?(lena - lenb):(lenb - lena);
+    if ((lena < q) || (lenb < q)) {
+        goto end_qgram;
+    }
+    hasha = ed_qgram_profile (stra, lena, q, &numa);
+    hashb = ed_qgram_profile (strb, lenb, q, &numb);
+    if ((NULL == hasha) || (NULL == hashb)) {
+        ret = -1;
+        goto end_qgram;
+    }
+    /* the number of the common q-grams, counted with multiplicity */
+    same = 0;
+    for (ia = 0, ib = 0; (ia < numa) && (ib < numb); ) {
+        if (hasha[ia] < hashb[ib]) {
+            ia ++;
+        } else if (hasha[ia] > hashb[ib]) {
+            ib ++;
+        } else {
+            same ++;
+            ia ++;
+            ib ++;
+        }
+    }
+    dq = numa + numb - 2 * same;
+    if ((int)((dq + 2 * q - 1) / (2 * q)) > ret) {
+        ret = (dq + 2 * q - 1) / (2 * q);
+    }
+
+end_qgram:
+    free (hashb);
+    free (hasha);
+    free (strb);
+    free (stra);
+    return ret;
+}
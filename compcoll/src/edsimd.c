@@ -0,0 +1,789 @@
+/**
+ * @file    edsimd.c
+ * @brief   Edit distance path by anti-diagonal wavefront, SIMD (SSE4.1/AVX2) version
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "editdistance.h"
+#include "ednuma.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define USE_EDSIMD_X86 1
+#include <immintrin.h>
+#else
+#define USE_EDSIMD_X86 0
+#endif
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+#define MAX(a,b) (((a)>(b))?(a):(b))
+
+/**
+ * 同一条反对角线 t = i + j 上的格子互相不依赖:
+ *   (i-1,j) 和 (i,j-1) 在 t-1 上, (i-1,j-1) 在 t-2 上。
+ * 所以按反对角线计算，每条线只要保存三条线的值(以 i 为下标)，方向码按反对角线顺序连续存放。
+ * 比较 a[j-1] 和 b[i-1] 时 j 随 i 增加而减小，所以预先把字符串 a 反过来存放，
+ * 使得 a[t-i-1] = ra[lena-t+i] 和 b[i-1] 一样随 i 连续。
+ * 格子的值不超过 max(lena, lenb)，较短的字符串用 16 位的值，一条指令计算的格子数是 32 位的两倍。
+ */
+typedef struct _ed_wave_t {
+    const wchar_t *ra;   /* the reversed string a */
+    const wchar_t *strb;
+    int lena;
+    int lenb;
+    int *diag[3];        /* the values of the diagonal t-2, t-1, t, indexed by i */
+    int16_t *diag16[3];  /* the same as diag[], if the values fit in 16 bits (EDWAVE_MAX16) */
+    unsigned char *dir;  /* the directions, diagonal by diagonal */
+    size_t *off;         /* the offset of the diagonal t in dir[] */
+} ed_wave_t;
+
+/* the max length of the strings for diag16[], the value + 1 of a cell still fits in int16_t */
+#define EDWAVE_MAX16 (INT16_MAX - 1)
+
+/* the range of i on diagonal t */
+#define WAVE_ILOW(pw, t)  MAX (0, (t) - (pw)->lena)
+#define WAVE_IHIGH(pw, t) MIN ((t), (pw)->lenb)
+
+/* 计算 [ibegin, iend) 的格子, 和 ed_edit_distance_path() 的选择顺序一致 */
+static void
+ed_wave_scalar (ed_wave_t *pw, int t, int ibegin, int iend)
+{
+    const int *dm2 = pw->diag[0];
+    const int *dm1 = pw->diag[1];
+    int *cur = pw->diag[2];
+    unsigned char *dir = pw->dir + pw->off[t] - WAVE_ILOW (pw, t);
+    const wchar_t *ra = pw->ra + pw->lena - t;
+    int i;
+    int pi; /* Pinsert */
+    int pd; /* Pdelete */
+    int pr; /* Pignore/Preplace */
+    char flg_equ;
+
+    for (i = ibegin; i < iend; i ++) {
+        pi = dm1[i - 1] + 1;
+        pd = dm1[i] + 1;
+        flg_equ = (ra[i] == pw->strb[i - 1]);
+        pr = dm2[i - 1] + (flg_equ?0:1);
+        if (pr < pi && pr <= pd) {
+            cur[i] = pr;
+            dir[i] = (flg_equ?EDIS_IGNORE:EDIS_REPLAC);
+        } else if (pi < pd) {
+            cur[i] = pi;
+            dir[i] = EDIS_INSERT;
+        } else {
+            cur[i] = pd;
+            dir[i] = EDIS_DELETE;
+        }
+    }
+}
+
+/* the same as ed_wave_scalar(), with diag16[] */
+static void
+ed_wave_scalar16 (ed_wave_t *pw, int t, int ibegin, int iend)
+{
+    const int16_t *dm2 = pw->diag16[0];
+    const int16_t *dm1 = pw->diag16[1];
+    int16_t *cur = pw->diag16[2];
+    unsigned char *dir = pw->dir + pw->off[t] - WAVE_ILOW (pw, t);
+    const wchar_t *ra = pw->ra + pw->lena - t;
+    int i;
+    int pi; /* Pinsert */
+    int pd; /* Pdelete */
+    int pr; /* Pignore/Preplace */
+    char flg_equ;
+
+    for (i = ibegin; i < iend; i ++) {
+        pi = dm1[i - 1] + 1;
+        pd = dm1[i] + 1;
+        flg_equ = (ra[i] == pw->strb[i - 1]);
+        pr = dm2[i - 1] + (flg_equ?0:1);
+        if (pr < pi && pr <= pd) {
+            cur[i] = pr;
+            dir[i] = (flg_equ?EDIS_IGNORE:EDIS_REPLAC);
+        } else if (pi < pd) {
+            cur[i] = pi;
+            dir[i] = EDIS_INSERT;
+        } else {
+            cur[i] = pd;
+            dir[i] = EDIS_DELETE;
+        }
+    }
+}
+
+#if USE_EDSIMD_X86
+/* 8 cells at a time, the values in 16 bits; the chars are compared in 32 bits and the masks packed to 16 bits */
+__attribute__((target("sse4.1")))
+static int
+ed_wave_sse41_16 (ed_wave_t *pw, int t, int ibegin, int iend)
+{
+    const int16_t *dm2 = pw->diag16[0];
+    const int16_t *dm1 = pw->diag16[1];
+    int16_t *cur = pw->diag16[2];
+    unsigned char *dir = pw->dir + pw->off[t] - WAVE_ILOW (pw, t);
+    const wchar_t *ra = pw->ra + pw->lena - t;
+    const __m128i one = _mm_set1_epi16 (1);
+    const __m128i cins = _mm_set1_epi16 (EDIS_INSERT);
+    const __m128i cdel = _mm_set1_epi16 (EDIS_DELETE);
+    const __m128i crep = _mm_set1_epi16 (EDIS_REPLAC);
+    const __m128i cign = _mm_set1_epi16 (EDIS_IGNORE);
+    __m128i pi, pd, pr, equ, mdiag, val, act;
+    int i;
+
+    for (i = ibegin; i + 8 <= iend; i += 8) {
+        pi = _mm_add_epi16 (_mm_loadu_si128 ((const __m128i *)(dm1 + i - 1)), one);
+        pd = _mm_add_epi16 (_mm_loadu_si128 ((const __m128i *)(dm1 + i)), one);
+        equ = _mm_packs_epi32 (
+            _mm_cmpeq_epi32 (_mm_loadu_si128 ((const __m128i *)(ra + i)), _mm_loadu_si128 ((const __m128i *)(pw->strb + i - 1))),
+            _mm_cmpeq_epi32 (_mm_loadu_si128 ((const __m128i *)(ra + i + 4)), _mm_loadu_si128 ((const __m128i *)(pw->strb + i + 3))));
+        pr = _mm_add_epi16 (_mm_loadu_si128 ((const __m128i *)(dm2 + i - 1)), _mm_andnot_si128 (equ, one));
+
+        /* pr < pi && pr <= pd */
+        mdiag = _mm_andnot_si128 (_mm_cmpgt_epi16 (pr, pd), _mm_cmpgt_epi16 (pi, pr));
+        val = _mm_min_epi16 (_mm_min_epi16 (pi, pd), pr);
+        act = _mm_blendv_epi8 (cdel, cins, _mm_cmpgt_epi16 (pd, pi));
+        act = _mm_blendv_epi8 (act, _mm_blendv_epi8 (crep, cign, equ), mdiag);
+
+        _mm_storeu_si128 ((__m128i *)(cur + i), val);
+        _mm_storel_epi64 ((__m128i *)(dir + i), _mm_packus_epi16 (act, act));
+    }
+    return i;
+}
+
+/* 16 cells at a time, the values in 16 bits */
+__attribute__((target("avx2")))
+static int
+ed_wave_avx2_16 (ed_wave_t *pw, int t, int ibegin, int iend)
+{
+    const int16_t *dm2 = pw->diag16[0];
+    const int16_t *dm1 = pw->diag16[1];
+    int16_t *cur = pw->diag16[2];
+    unsigned char *dir = pw->dir + pw->off[t] - WAVE_ILOW (pw, t);
+    const wchar_t *ra = pw->ra + pw->lena - t;
+    const __m256i one = _mm256_set1_epi16 (1);
+    const __m256i cins = _mm256_set1_epi16 (EDIS_INSERT);
+    const __m256i cdel = _mm256_set1_epi16 (EDIS_DELETE);
+    const __m256i crep = _mm256_set1_epi16 (EDIS_REPLAC);
+    const __m256i cign = _mm256_set1_epi16 (EDIS_IGNORE);
+    __m256i pi, pd, pr, equ, mdiag, val, act;
+    int i;
+
+    for (i = ibegin; i + 16 <= iend; i += 16) {
+        pi = _mm256_add_epi16 (_mm256_loadu_si256 ((const __m256i *)(dm1 + i - 1)), one);
+        pd = _mm256_add_epi16 (_mm256_loadu_si256 ((const __m256i *)(dm1 + i)), one);
+        /* the pack works in each 128-bit lane, the masks of the cells 0..3, 8..11, 4..7, 12..15 are put back in order */
+        equ = _mm256_packs_epi32 (
+            _mm256_cmpeq_epi32 (_mm256_loadu_si256 ((const __m256i *)(ra + i)), _mm256_loadu_si256 ((const __m256i *)(pw->strb + i - 1))),
+            _mm256_cmpeq_epi32 (_mm256_loadu_si256 ((const __m256i *)(ra + i + 8)), _mm256_loadu_si256 ((const __m256i *)(pw->strb + i + 7))));
+        equ = _mm256_permute4x64_epi64 (equ, 0xD8);
+        pr = _mm256_add_epi16 (_mm256_loadu_si256 ((const __m256i *)(dm2 + i - 1)), _mm256_andnot_si256 (equ, one));
+
+        mdiag = _mm256_andnot_si256 (_mm256_cmpgt_epi16 (pr, pd), _mm256_cmpgt_epi16 (pi, pr));
+        val = _mm256_min_epi16 (_mm256_min_epi16 (pi, pd), pr);
+        act = _mm256_blendv_epi8 (cdel, cins, _mm256_cmpgt_epi16 (pd, pi));
+        act = _mm256_blendv_epi8 (act, _mm256_blendv_epi8 (crep, cign, equ), mdiag);
+
+        _mm256_storeu_si256 ((__m256i *)(cur + i), val);
+        /* bytes 0..7 of the lanes hold the codes 0..7, 8..15 */
+        act = _mm256_packus_epi16 (act, act);
+        _mm_storel_epi64 ((__m128i *)(dir + i), _mm256_castsi256_si128 (act));
+        _mm_storel_epi64 ((__m128i *)(dir + i + 8), _mm256_extracti128_si256 (act, 1));
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1")))
+static int
+ed_wave_sse41 (ed_wave_t *pw, int t, int ibegin, int iend)
+{
+    const int *dm2 = pw->diag[0];
+    const int *dm1 = pw->diag[1];
+    int *cur = pw->diag[2];
+    unsigned char *dir = pw->dir + pw->off[t] - WAVE_ILOW (pw, t);
+    const wchar_t *ra = pw->ra + pw->lena - t;
+    const __m128i one = _mm_set1_epi32 (1);
+    const __m128i cins = _mm_set1_epi32 (EDIS_INSERT);
+    const __m128i cdel = _mm_set1_epi32 (EDIS_DELETE);
+    const __m128i crep = _mm_set1_epi32 (EDIS_REPLAC);
+    const __m128i cign = _mm_set1_epi32 (EDIS_IGNORE);
+    __m128i pi, pd, pr, equ, mdiag, val, act;
+    int i;
+    int32_t codes;
+
+    for (i = ibegin; i + 4 <= iend; i += 4) {
+        pi = _mm_add_epi32 (_mm_loadu_si128 ((const __m128i *)(dm1 + i - 1)), one);
+        pd = _mm_add_epi32 (_mm_loadu_si128 ((const __m128i *)(dm1 + i)), one);
+        equ = _mm_cmpeq_epi32 (_mm_loadu_si128 ((const __m128i *)(ra + i)), _mm_loadu_si128 ((const __m128i *)(pw->strb + i - 1)));
+        pr = _mm_add_epi32 (_mm_loadu_si128 ((const __m128i *)(dm2 + i - 1)), _mm_andnot_si128 (equ, one));
+
+        /* pr < pi && pr <= pd */
+        mdiag = _mm_andnot_si128 (_mm_cmpgt_epi32 (pr, pd), _mm_cmpgt_epi32 (pi, pr));
+        val = _mm_min_epi32 (_mm_min_epi32 (pi, pd), pr);
+        act = _mm_blendv_epi8 (cdel, cins, _mm_cmpgt_epi32 (pd, pi));
+        act = _mm_blendv_epi8 (act, _mm_blendv_epi8 (crep, cign, equ), mdiag);
+
+        _mm_storeu_si128 ((__m128i *)(cur + i), val);
+        act = _mm_packs_epi32 (act, act);
+        act = _mm_packus_epi16 (act, act);
+        codes = _mm_cvtsi128_si32 (act);
+        memcpy (dir + i, &codes, 4);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static int
+ed_wave_avx2 (ed_wave_t *pw, int t, int ibegin, int iend)
+{
+    const int *dm2 = pw->diag[0];
+    const int *dm1 = pw->diag[1];
+    int *cur = pw->diag[2];
+    unsigned char *dir = pw->dir + pw->off[t] - WAVE_ILOW (pw, t);
+    const wchar_t *ra = pw->ra + pw->lena - t;
+    const __m256i one = _mm256_set1_epi32 (1);
+    const __m256i cins = _mm256_set1_epi32 (EDIS_INSERT);
+    const __m256i cdel = _mm256_set1_epi32 (EDIS_DELETE);
+    const __m256i crep = _mm256_set1_epi32 (EDIS_REPLAC);
+    const __m256i cign = _mm256_set1_epi32 (EDIS_IGNORE);
+    __m256i pi, pd, pr, equ, mdiag, val, act;
+    int i;
+    int32_t codes;
+
+    for (i = ibegin; i + 8 <= iend; i += 8) {
+        pi = _mm256_add_epi32 (_mm256_loadu_si256 ((const __m256i *)(dm1 + i - 1)), one);
+        pd = _mm256_add_epi32 (_mm256_loadu_si256 ((const __m256i *)(dm1 + i)), one);
+        equ = _mm256_cmpeq_epi32 (_mm256_loadu_si256 ((const __m256i *)(ra + i)), _mm256_loadu_si256 ((const __m256i *)(pw->strb + i - 1)));
+        pr = _mm256_add_epi32 (_mm256_loadu_si256 ((const __m256i *)(dm2 + i - 1)), _mm256_andnot_si256 (equ, one));
+
+        mdiag = _mm256_andnot_si256 (_mm256_cmpgt_epi32 (pr, pd), _mm256_cmpgt_epi32 (pi, pr));
+        val = _mm256_min_epi32 (_mm256_min_epi32 (pi, pd), pr);
+        act = _mm256_blendv_epi8 (cdel, cins, _mm256_cmpgt_epi32 (pd, pi));
+        act = _mm256_blendv_epi8 (act, _mm256_blendv_epi8 (crep, cign, equ), mdiag);
+
+        _mm256_storeu_si256 ((__m256i *)(cur + i), val);
+        /* the pack works in each 128-bit lane: bytes 0..3 of the lanes hold the codes 0..3, 4..7 */
+        act = _mm256_packs_epi32 (act, act);
+        act = _mm256_packus_epi16 (act, act);
+        codes = _mm_cvtsi128_si32 (_mm256_castsi256_si128 (act));
+        memcpy (dir + i, &codes, 4);
+        codes = _mm_cvtsi128_si32 (_mm256_extracti128_si256 (act, 1));
+        memcpy (dir + i + 4, &codes, 4);
+    }
+    return i;
+}
+#endif /* USE_EDSIMD_X86 */
+
+/**
+ * @brief 返回本机可以使用的最好的 SIMD 指令集
+ *
+ * @return EDSIMD_AVX2, EDSIMD_SSE41 或 EDSIMD_SCALAR
+ */
+int
+ed_simd_detect (void)
+{
+#if USE_EDSIMD_X86
+    if (sizeof (wchar_t) == sizeof (int32_t)) {
+        __builtin_cpu_init ();
+        if (__builtin_cpu_supports ("avx2")) {
+            return EDSIMD_AVX2;
+        }
+        if (__builtin_cpu_supports ("sse4.1")) {
+            return EDSIMD_SSE41;
+        }
+    }
+#endif
+    return EDSIMD_SCALAR;
+}
+
+static size_t
+ed_wave_traceback (ed_wave_t *pw, char *path)
+{
+    int i = pw->lenb;
+    int j = pw->lena;
+    size_t num = pw->lena + pw->lenb;
+    char action;
+
+    while (i > 0 || j > 0) {
+        action = pw->dir[pw->off[i + j] + i - WAVE_ILOW (pw, i + j)];
+        assert (num > 0);
+        path[-- num] = action;
+        switch (action) {
+        case EDIS_INSERT:
+            i --;
+            break;
+        case EDIS_DELETE:
+            j --;
+            break;
+        case EDIS_REPLAC:
+        case EDIS_IGNORE:
+            i --;
+            j --;
+            break;
+        default:
+            assert (0);
+            break;
+        }
+    }
+    if (num > 0) {
+        memmove (path, path + num, sizeof (char) * (pw->lena + pw->lenb - num));
+    }
+    return pw->lena + pw->lenb - num;
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, 按反对角线的 SIMD 版本
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ * @param simd : 使用的指令集 EDSIMD_*, EDSIMD_AUTO 为自动选择
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 结果和 ed_edit_distance_path() 完全相同(包括路径)。时间O(m*n), 每次计算一条反对角线上的 8(SSE4.1)或16(AVX2)个格子,
+ * 字符串长于 EDWAVE_MAX16 时值为 32 位, 每次 4 或 8 个格子;
+ * 空间O(m*n)，但每个格子只用一个字节存储方向，值只保留三条反对角线。
+ * path 为 NULL 时只计算距离, 同 ed_edit_distance_bitpar()。
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_simd (strcmp_t *cmpinfo, int simd, char *path, size_t *ret_numpath)
+{
+    ed_wave_t wave;
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    size_t i;
+    int t;
+    int ilow;
+    int ihigh;
+    int *tmp;
+    int16_t *tmp16;
+    void *diagbuf = NULL;
+    char flg_narrow;
+    int ret = -1;
+
+    assert (NULL != cmpinfo);
+    if (NULL == path) {
+        return ed_edit_distance_bitpar (cmpinfo);
+    }
+    assert (NULL != ret_numpath);
+    if (EDSIMD_AUTO == simd) {
+        simd = ed_simd_detect ();
+    }
+    memset (&wave, 0, sizeof (wave));
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL == stra) || (NULL == strb)) {
+        goto end_simd;
+    }
+    /* reverse a in place */
+    for (i = 0; i < lena / 2; i ++) {
+        wchar_t ch = stra[i];
+        stra[i] = stra[lena - 1 - i];
+        stra[lena - 1 - i] = ch;
+    }
+    wave.ra = stra;
+    wave.strb = strb;
+    wave.lena = lena;
+    wave.lenb = lenb;
+    flg_narrow = ((lena <= EDWAVE_MAX16) && (lenb <= EDWAVE_MAX16));
+    diagbuf = malloc ((flg_narrow?sizeof (int16_t):sizeof (int)) * (lenb + 1) * 3);
+    wave.off = (size_t *)malloc (sizeof (size_t) * (lena + lenb + 2));
+    wave.dir = (unsigned char *)malloc (sizeof (unsigned char) * (lena + 1) * (lenb + 1));
+    if ((NULL == diagbuf) || (NULL == wave.off) || (NULL == wave.dir)) {
+        goto end_simd;
+    }
+    if (flg_narrow) {
+        wave.diag16[0] = (int16_t *)diagbuf;
+        wave.diag16[1] = wave.diag16[0] + (lenb + 1);
+        wave.diag16[2] = wave.diag16[1] + (lenb + 1);
+    } else {
+        wave.diag[0] = (int *)diagbuf;
+        wave.diag[1] = wave.diag[0] + (lenb + 1);
+        wave.diag[2] = wave.diag[1] + (lenb + 1);
+    }
+    wave.off[0] = 0;
+    for (t = 0; t <= (int)(lena + lenb); t ++) {
+        wave.off[t + 1] = wave.off[t] + WAVE_IHIGH (&wave, t) - WAVE_ILOW (&wave, t) + 1;
+    }
+
+    for (t = 0; t <= (int)(lena + lenb); t ++) {
+        ilow = WAVE_ILOW (&wave, t);
+        ihigh = WAVE_IHIGH (&wave, t);
+        /* the cells on row 0 and column 0 */
+        if (0 == ilow) {
+            if (flg_narrow) {
+                wave.diag16[2][0] = t;
+            } else {
+                wave.diag[2][0] = t;
+            }
+            wave.dir[wave.off[t]] = (t > 0)?EDIS_DELETE:EDIS_NONE;
+            ilow = 1;
+        }
+        if (t == ihigh && t > 0) {
+            if (flg_narrow) {
+                wave.diag16[2][t] = t;
+            } else {
+                wave.diag[2][t] = t;
+            }
+            wave.dir[wave.off[t] + t - WAVE_ILOW (&wave, t)] = EDIS_INSERT;
+            ihigh --;
+        }
+        i = ilow;
+        switch (simd) {
+#if USE_EDSIMD_X86
+        case EDSIMD_AVX2:
+            i = (flg_narrow?ed_wave_avx2_16:ed_wave_avx2) (&wave, t, ilow, ihigh + 1);
+            break;
+        case EDSIMD_SSE41:
+            i = (flg_narrow?ed_wave_sse41_16:ed_wave_sse41) (&wave, t, ilow, ihigh + 1);
+            break;
+#endif
+        default:
+            break;
+        }
+        if (flg_narrow) {
+            ed_wave_scalar16 (&wave, t, i, ihigh + 1);
+        } else {
+            ed_wave_scalar (&wave, t, i, ihigh + 1);
+        }
+
+        tmp = wave.diag[0];
+        wave.diag[0] = wave.diag[1];
+        wave.diag[1] = wave.diag[2];
+        wave.diag[2] = tmp;
+        tmp16 = wave.diag16[0];
+        wave.diag16[0] = wave.diag16[1];
+        wave.diag16[1] = wave.diag16[2];
+        wave.diag16[2] = tmp16;
+    }
+    /* the last diagonal is now at diag[1] */
+    ret = (flg_narrow?wave.diag16[1][lenb]:wave.diag[1][lenb]);
+    *ret_numpath = ed_wave_traceback (&wave, path);
+    ed_numa_account ("simd directions", wave.dir, sizeof (unsigned char) * (lena + 1) * (lenb + 1));
+
+end_simd:
+    if (NULL != wave.dir) {
+        free (wave.dir);
+    }
+    if (NULL != wave.off) {
+        free (wave.off);
+    }
+    if (NULL != diagbuf) {
+        free (diagbuf);
+    }
+    if (NULL != stra) {
+        free (stra);
+    }
+    if (NULL != strb) {
+        free (strb);
+    }
+    return ret;
+}
+
+/**********************************************************************************/
+/* 多对字符串的距离: 每对字符串占一个 16 位的通道, 一次计算所有通道的同一个格子 */
+
+#define EDBATCH_LANES  16        /* the pairs computed together, 8 per SSE register, 16 per AVX2 register */
+#define EDBATCH_MAXLEN (INT16_MAX - 1) /* the longer pairs are computed one by one; the sum of a value and 1 fits in int16 */
+
+typedef struct _ed_batch_pair_t {
+    size_t idx;
+    size_t lena;
+    size_t lenb;
+} ed_batch_pair_t;
+
+/* 按 b 的长度, 再按 a 的长度排序, 使同一批的字符串长度相近 */
+static int
+ed_batch_cmp (const void *a, const void *b)
+{
+    const ed_batch_pair_t *pa = (const ed_batch_pair_t *)a;
+    const ed_batch_pair_t *pb = (const ed_batch_pair_t *)b;
+    if (pa->lenb != pb->lenb) {
+        return (pa->lenb < pb->lenb)?-1:1;
+    }
+    if (pa->lena != pb->lena) {
+        return (pa->lena < pb->lena)?-1:1;
+    }
+    return (pa->idx < pb->idx)?-1:((pa->idx > pb->idx)?1:0);
+}
+
+/**
+ * 把一对字符串的字符换成从 1 开始的编号(相同的字符编号相同)，存入各自通道
+ * @param hkey, hval : 哈希表, 2^hbits 个(大于两个字符串的长度和)
+ * @param slots : 编号为 n 的字符在表中的位置存入 slots[n - 1], 用于下一对之前只清掉用过的位置
+ *
+ * 乘法哈希取乘积的高 hbits 位; 低位只由字符的低位决定, 编码相邻的汉字会挤在一起
+ */
+static void
+ed_batch_remap (const wchar_t *str, size_t len, uint16_t *ids, wchar_t *hkey, uint16_t *hval, int hbits, uint32_t *slots, uint16_t *num)
+{
+    const uint32_t mask = ((uint32_t)1 << hbits) - 1;
+    size_t i;
+    uint32_t h;
+
+    for (i = 0; i < len; i ++) {
+        h = ((uint32_t)str[i] * 2654435761U) >> (32 - hbits);
+        while (0 != hval[h] && hkey[h] != str[i]) {
+            h = (h + 1) & mask;
+        }
+        if (0 == hval[h]) {
+            hkey[h] = str[i];
+            hval[h] = ++ (*num);
+            slots[*num - 1] = h;
+        }
+        ids[i * EDBATCH_LANES] = hval[h];
+    }
+}
+
+/* 由第 i-1 行计算第 i 行, row[j * EDBATCH_LANES + k] 是第 k 对字符串的 D[i][j] */
+static void
+ed_batch_row_scalar (int16_t *row, const uint16_t *ida, const uint16_t *idb, size_t lena, int16_t rowi)
+{
+    int16_t diag[EDBATCH_LANES];
+    int16_t left[EDBATCH_LANES];
+    int16_t up;
+    int16_t val;
+    size_t j;
+    int k;
+
+    for (k = 0; k < EDBATCH_LANES; k ++) {
+        diag[k] = row[k];
+        row[k] = rowi;
+        left[k] = rowi;
+    }
+    for (j = 1; j <= lena; j ++) {
+        row += EDBATCH_LANES;
+        for (k = 0; k < EDBATCH_LANES; k ++) {
+            up = row[k];
+            val = diag[k] + ((ida[k] == idb[k])?0:1);
+            val = MIN (val, MIN (up, left[k]) + 1);
+            row[k] = val;
+            diag[k] = up;
+            left[k] = val;
+        }
+        ida += EDBATCH_LANES;
+    }
+}
+
+#if USE_EDSIMD_X86
+__attribute__((target("sse4.1")))
+static void
+ed_batch_row_sse41 (int16_t *row, const uint16_t *ida, const uint16_t *idb, size_t lena, int16_t rowi)
+{
+    const __m128i one = _mm_set1_epi16 (1);
+    const __m128i b0 = _mm_loadu_si128 ((const __m128i *)idb);
+    const __m128i b1 = _mm_loadu_si128 ((const __m128i *)(idb + 8));
+    __m128i diag0 = _mm_loadu_si128 ((const __m128i *)row);
+    __m128i diag1 = _mm_loadu_si128 ((const __m128i *)(row + 8));
+    __m128i left0 = _mm_set1_epi16 (rowi);
+    __m128i left1 = left0;
+    __m128i up0, up1;
+    size_t j;
+
+    _mm_storeu_si128 ((__m128i *)row, left0);
+    _mm_storeu_si128 ((__m128i *)(row + 8), left1);
+    for (j = 1; j <= lena; j ++) {
+        row += EDBATCH_LANES;
+        up0 = _mm_loadu_si128 ((const __m128i *)row);
+        up1 = _mm_loadu_si128 ((const __m128i *)(row + 8));
+        /* diag + 1 - (a == b), the compare gives -1 for the equal ones */
+        diag0 = _mm_add_epi16 (_mm_add_epi16 (diag0, one), _mm_cmpeq_epi16 (_mm_loadu_si128 ((const __m128i *)ida), b0));
+        diag1 = _mm_add_epi16 (_mm_add_epi16 (diag1, one), _mm_cmpeq_epi16 (_mm_loadu_si128 ((const __m128i *)(ida + 8)), b1));
+        left0 = _mm_min_epi16 (diag0, _mm_add_epi16 (_mm_min_epi16 (up0, left0), one));
+        left1 = _mm_min_epi16 (diag1, _mm_add_epi16 (_mm_min_epi16 (up1, left1), one));
+        _mm_storeu_si128 ((__m128i *)row, left0);
+        _mm_storeu_si128 ((__m128i *)(row + 8), left1);
+        diag0 = up0;
+        diag1 = up1;
+        ida += EDBATCH_LANES;
+    }
+}
+
+__attribute__((target("avx2")))
+static void
+ed_batch_row_avx2 (int16_t *row, const uint16_t *ida, const uint16_t *idb, size_t lena, int16_t rowi)
+{
+    const __m256i one = _mm256_set1_epi16 (1);
+    const __m256i b = _mm256_loadu_si256 ((const __m256i *)idb);
+    __m256i diag = _mm256_loadu_si256 ((const __m256i *)row);
+    __m256i left = _mm256_set1_epi16 (rowi);
+    __m256i up;
+    size_t j;
+
+    _mm256_storeu_si256 ((__m256i *)row, left);
+    for (j = 1; j <= lena; j ++) {
+        row += EDBATCH_LANES;
+        up = _mm256_loadu_si256 ((const __m256i *)row);
+        diag = _mm256_add_epi16 (_mm256_add_epi16 (diag, one), _mm256_cmpeq_epi16 (_mm256_loadu_si256 ((const __m256i *)ida), b));
+        left = _mm256_min_epi16 (diag, _mm256_add_epi16 (_mm256_min_epi16 (up, left), one));
+        _mm256_storeu_si256 ((__m256i *)row, left);
+        diag = up;
+        ida += EDBATCH_LANES;
+    }
+}
+#endif /* USE_EDSIMD_X86 */
+
+/**
+ * @brief 计算多对字符串的距离
+ *
+ * @param cmpinfo : 每对字符串的访问接口(使用 cb_len, cb_getval), num 个
+ * @param num : 字符串对的个数
+ * @param simd : 使用的指令集 EDSIMD_*, EDSIMD_AUTO 为自动选择
+ * @param ret_dist : 返回每对字符串的距离, num 个
+ *
+ * @return 成功返回 0, 内存不足返回 -1
+ *
+ * 结果和对每对字符串调用 ed_edit_distance() 相同。
+ * 字符串对按长度排序后每 16 对一批，每对占一个 16 位的通道，一条 AVX2 指令(或两条 SSE4.1 指令)计算 16 对的同一个格子;
+ * 一批按其中最长的字符串计算，每对的距离在它自己的 (lenb, lena) 格子处取出。
+ * 字符换成每对字符串内部的编号以便用 16 位比较。
+ * 格子的值不超过较长字符串的长度, 加 1 后也不能超出 int16, 所以长度超过 32766 的字符串对用 ed_edit_distance_bitpar() 单独计算。
+ * 适合大量短字符串(如所有章节两两之间)的距离。
+ */
+int
+ed_edit_distance_batch (strcmp_t **cmpinfo, size_t num, int simd, int *ret_dist)
+{
+    ed_batch_pair_t *pairs = NULL;
+    ed_batch_pair_t *pp;
+    wchar_t *stra;
+    wchar_t *strb;
+    uint16_t *ida = NULL;
+    uint16_t *idb = NULL;
+    int16_t *row = NULL;
+    wchar_t *hkey = NULL;
+    uint16_t *hval = NULL;
+    uint32_t *slots = NULL;
+    int hbits = 1;
+    size_t npair = 0;
+    size_t maxa;
+    size_t maxb;
+    size_t alla = 0;
+    size_t allb = 0;
+    size_t maxsum = 0;
+    size_t s;
+    size_t i;
+    size_t k;
+    size_t nlane;
+    uint16_t nid;
+    int ret = -1;
+
+    assert (NULL != cmpinfo);
+    assert (NULL != ret_dist);
+    if (EDSIMD_AUTO == simd) {
+        simd = ed_simd_detect ();
+    }
+    pairs = (ed_batch_pair_t *)malloc (sizeof (ed_batch_pair_t) * (num + 1));
+    if (NULL == pairs) {
+        return -1;
+    }
+    for (k = 0; k < num; k ++) {
+        pp = &(pairs[npair]);
+        pp->idx = k;
+        pp->lena = cmpinfo[k]->cb_len (cmpinfo[k]->userdata_str, 0);
+        pp->lenb = cmpinfo[k]->cb_len (cmpinfo[k]->userdata_str, 1);
+        if ((pp->lena > EDBATCH_MAXLEN) || (pp->lenb > EDBATCH_MAXLEN)) {
+            ret_dist[k] = ed_edit_distance_bitpar (cmpinfo[k]);
+            if (ret_dist[k] < 0) {
+                goto end_batch;
+            }
+            continue;
+        }
+        maxsum = MAX (maxsum, pp->lena + pp->lenb);
+        alla = MAX (alla, pp->lena);
+        allb = MAX (allb, pp->lenb);
+        npair ++;
+    }
+    qsort (pairs, npair, sizeof (ed_batch_pair_t), ed_batch_cmp);
+    while (((size_t)1 << hbits) <= maxsum * 2) {
+        hbits ++;
+    }
+    hkey = (wchar_t *)malloc (sizeof (wchar_t) * ((size_t)1 << hbits));
+    hval = (uint16_t *)calloc ((size_t)1 << hbits, sizeof (uint16_t));
+    slots = (uint32_t *)malloc (sizeof (uint32_t) * (maxsum + 1));
+    /* 缓冲按所有批中最长的字符串分配一次; 多一个位置给长度为 0 的情况。
+     * 通道中超出该对字符串长度的位置留着上一批的编号: 那些格子不会影响到 (lenb, lena) 格子, 所以不用清零 */
+    ida = (uint16_t *)calloc ((alla + 1) * EDBATCH_LANES, sizeof (uint16_t));
+    idb = (uint16_t *)calloc ((allb + 1) * EDBATCH_LANES, sizeof (uint16_t));
+    row = (int16_t *)malloc (sizeof (int16_t) * (alla + 1) * EDBATCH_LANES);
+    if ((NULL == hkey) || (NULL == hval) || (NULL == slots) || (NULL == ida) || (NULL == idb) || (NULL == row)) {
+        goto end_batch;
+    }
+
+    for (s = 0; s < npair; s += EDBATCH_LANES) {
+        nlane = MIN (npair - s, EDBATCH_LANES);
+        maxa = 0;
+        maxb = pairs[s + nlane - 1].lenb;
+        for (k = 0; k < nlane; k ++) {
+            maxa = MAX (maxa, pairs[s + k].lena);
+        }
+        for (k = 0; k < nlane; k ++) {
+            pp = &(pairs[s + k]);
+            stra = ed_fetch_string (cmpinfo[pp->idx], 0, &(pp->lena));
+            strb = ed_fetch_string (cmpinfo[pp->idx], 1, &(pp->lenb));
+            if ((NULL == stra) || (NULL == strb)) {
+                free (stra);
+                free (strb);
+                goto end_batch;
+            }
+            nid = 0;
+            ed_batch_remap (stra, pp->lena, ida + k, hkey, hval, hbits, slots, &nid);
+            ed_batch_remap (strb, pp->lenb, idb + k, hkey, hval, hbits, slots, &nid);
+            free (stra);
+            free (strb);
+            /* 只清掉这一对用过的位置 */
+            for (; nid > 0; nid --) {
+                hval[slots[nid - 1]] = 0;
+            }
+            if (0 == pp->lenb) {
+                ret_dist[pp->idx] = pp->lena;
+            }
+        }
+        for (i = 0; i <= maxa; i ++) {
+            for (k = 0; k < EDBATCH_LANES; k ++) {
+                row[i * EDBATCH_LANES + k] = i;
+            }
+        }
+
+        for (i = 1; i <= maxb; i ++) {
+            switch (simd) {
+#if USE_EDSIMD_X86
+            case EDSIMD_AVX2:
+                ed_batch_row_avx2 (row, ida, idb + (i - 1) * EDBATCH_LANES, maxa, i);
+                break;
+            case EDSIMD_SSE41:
+                ed_batch_row_sse41 (row, ida, idb + (i - 1) * EDBATCH_LANES, maxa, i);
+                break;
+#endif
+            default:
+                ed_batch_row_scalar (row, ida, idb + (i - 1) * EDBATCH_LANES, maxa, i);
+                break;
+            }
+            for (k = 0; k < nlane; k ++) {
+                pp = &(pairs[s + k]);
+                if (pp->lenb == i) {
+                    ret_dist[pp->idx] = row[pp->lena * EDBATCH_LANES + k];
+                }
+            }
+        }
+    }
+    ret = 0;
+
+end_batch:
+    free (row);
+    free (idb);
+    free (ida);
+    free (slots);
+    free (hval);
+    free (hkey);
+    free (pairs);
+    return ret;
+}
@@ -0,0 +1,312 @@
+/**
+ * @file    edtiled.c
+ * @brief   Edit distance path by the tiles of the matrix, multi-threaded version
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @license GPL 2.0/LGPL 2.1
+ * @date    2016-03-13
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h> /* sysconf() */
+#include <pthread.h>
+#include <assert.h>
+
+#include "editdistance.h"
+#include "ednuma.h"
+
+#define EDTILE_SIZE 256 /* the rows and columns of a tile */
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+#define MAX(a,b) (((a)>(b))?(a):(b))
+
+/**
+ * 矩阵分成 EDTILE_SIZE x EDTILE_SIZE 的块, 块 (I,J) 只依赖于 (I-1,J) 和 (I,J-1)，
+ * 所以同一条块反对角线 I + J 上的块可以同时计算，每算完一条块反对角线所有线程同步一次。
+ *
+ * 块之间只通过边界传递值:
+ *   hrow[I][j] = D[I * EDTILE_SIZE][j]，第 I 个块行的顶部
+ *   vcol[J][i] = D[i][J * EDTILE_SIZE]，第 J 个块列的左边
+ * 方向码则写入完整的 (lenb + 1) x (lena + 1) 字节矩阵，回溯时单线程进行。
+ */
+typedef struct _ed_tiled_t {
+    const wchar_t *stra;
+    const wchar_t *strb;
+    int lena;
+    int lenb;
+    int ntilerow;   /* the number of tiles in the vertical */
+    int ntilecol;   /* the number of tiles in the horizontal */
+    int *hrow;      /* (ntilerow + 1) x (lena + 1) */
+    int *vcol;      /* (ntilecol + 1) x (lenb + 1) */
+    unsigned char *dir; /* (lenb + 1) x (lena + 1) */
+
+    int *next;      /* the next tile to be processed on each tile diagonal */
+    int nworker;    /* the index of the next worker, to pin it to a CPU */
+    pthread_mutex_t start; /* hold by the main thread until the barrier is ready */
+    pthread_barrier_t barrier;
+} ed_tiled_t;
+
+/* 计算块 (ti, tj), row -- 一行的临时缓冲, EDTILE_SIZE + 1 个 */
+static void
+ed_tiled_block (ed_tiled_t *pt, int ti, int tj, int *row)
+{
+    int i0 = ti * EDTILE_SIZE;
+    int j0 = tj * EDTILE_SIZE;
+    int i1 = MIN (i0 + EDTILE_SIZE, pt->lenb);
+    int j1 = MIN (j0 + EDTILE_SIZE, pt->lena);
+    const int *top = pt->hrow + (size_t)ti * (pt->lena + 1) + j0;
+    int *bottom = pt->hrow + (size_t)(ti + 1) * (pt->lena + 1) + j0;
+    const int *left = pt->vcol + (size_t)tj * (pt->lenb + 1) + i0;
+    int *right = pt->vcol + (size_t)(tj + 1) * (pt->lenb + 1) + i0;
+    unsigned char *dir;
+    const wchar_t *a = pt->stra + j0 - 1;
+    wchar_t chb;
+    int w = j1 - j0;
+    int i;
+    int j;
+    int pi; /* Pinsert */
+    int pd; /* Pdelete */
+    int pr; /* Pignore/Preplace */
+    int diag;
+    char flg_equ;
+
+    /* row[c] = D[i][j0 + c] */
+    memcpy (row, top, sizeof (int) * (w + 1));
+    for (i = i0 + 1; i <= i1; i ++) {
+        dir = pt->dir + (size_t)i * (pt->lena + 1) + j0;
+        chb = pt->strb[i - 1];
+        diag = row[0];
+        row[0] = left[i - i0];
+        for (j = 1; j <= w; j ++) {
+            pi = row[j] + 1;
+            pd = row[j - 1] + 1;
+            flg_equ = (a[j] == chb);
+            pr = diag + (flg_equ?0:1);
+            diag = row[j];
+            /* 和 ed_edit_distance_path() 的选择顺序一致 */
+            if (pr < pi && pr <= pd) {
+                row[j] = pr;
+                dir[j] = (flg_equ?EDIS_IGNORE:EDIS_REPLAC);
+            } else if (pi < pd) {
+                row[j] = pi;
+                dir[j] = EDIS_INSERT;
+            } else {
+                row[j] = pd;
+                dir[j] = EDIS_DELETE;
+            }
+        }
+        right[i - i0] = row[w];
+    }
+    memcpy (bottom + 1, row + 1, sizeof (int) * w);
+}
+
+/* 返回 NULL, 失败时为 EDTILED_FAILED; 失败的线程不取块但仍然等待每个屏障, 其他线程不会被挂起 */
+#define EDTILED_FAILED ((void *)1)
+
+static void *
+ed_tiled_worker (void *userdata)
+{
+    ed_tiled_t *pt = (ed_tiled_t *)userdata;
+    int *row;
+    int d;
+    int k;
+    int ti;
+    int tlow;
+    int thigh;
+
+    ed_numa_pin_worker (__sync_fetch_and_add (&(pt->nworker), 1));
+    pthread_mutex_lock (&(pt->start));
+    pthread_mutex_unlock (&(pt->start));
+    row = (int *)malloc (sizeof (int) * (EDTILE_SIZE + 1));
+    for (d = 0; d < pt->ntilerow + pt->ntilecol - 1; d ++) {
+        tlow = MAX (0, d - pt->ntilecol + 1);
+        thigh = MIN (d, pt->ntilerow - 1);
+        while ((NULL != row) && ((k = __sync_fetch_and_add (&(pt->next[d]), 1)) <= thigh - tlow)) {
+            ti = tlow + k;
+            ed_tiled_block (pt, ti, d - ti, row);
+        }
+        pthread_barrier_wait (&(pt->barrier));
+    }
+    if (NULL == row) {
+        return EDTILED_FAILED;
+    }
+    free (row);
+    return NULL;
+}
+
+static size_t
+ed_tiled_traceback (ed_tiled_t *pt, char *path)
+{
+    int i = pt->lenb;
+    int j = pt->lena;
+    size_t num = pt->lena + pt->lenb;
+    char action;
+
+    while (i > 0 || j > 0) {
+        if (0 == i) {
+            action = EDIS_DELETE;
+        } else if (0 == j) {
+            action = EDIS_INSERT;
+        } else {
+            action = pt->dir[(size_t)i * (pt->lena + 1) + j];
+        }
+        assert (num > 0);
+        path[-- num] = action;
+        switch (action) {
+        case EDIS_INSERT:
+            i --;
+            break;
+        case EDIS_DELETE:
+            j --;
+            break;
+        case EDIS_REPLAC:
+        case EDIS_IGNORE:
+            i --;
+            j --;
+            break;
+        default:
+            assert (0);
+            break;
+        }
+    }
+    if (num > 0) {
+        memmove (path, path + num, sizeof (char) * (pt->lena + pt->lenb - num));
+    }
+    return pt->lena + pt->lenb - num;
+}
+
+/**
+ * @brief 计算两个字符串的距离和修改路径, 多线程分块版本
+ *
+ * @param cmpinfo : 字符串的访问接口(使用 cb_len, cb_getval)
+ * @param nthreads : 线程数, <= 0 时为 CPU 的个数
+ * @param path : 修改路径
+ * @param ret_numpath : 修改路径缓冲长度
+ *
+ * @return 返回距离值, 失败返回 -1
+ *
+ * 结果和 ed_edit_distance_path() 完全相同(包括路径)。时间O(m*n/nthreads), 空间O(m*n)，每个格子一个字节。
+ *    the buffer of the path should be >= strlen(stra)+strlen(strb)
+ */
+int
+ed_edit_distance_path_tiled (strcmp_t *cmpinfo, int nthreads, char *path, size_t *ret_numpath)
+{
+    ed_tiled_t tiled;
+    pthread_t *threads = NULL;
+    wchar_t *stra = NULL;
+    wchar_t *strb = NULL;
+    size_t lena = 0;
+    size_t lenb = 0;
+    size_t szhrow = 0;
+    size_t szvcol = 0;
+    size_t szdir = 0;
+    size_t i;
+    void *res;
+    char flg_failed = 0;
+    int k;
+    int ret = -1;
+
+    assert (NULL != cmpinfo);
+    assert (NULL != path);
+    assert (NULL != ret_numpath);
+    if (nthreads < 1) {
+        nthreads = sysconf (_SC_NPROCESSORS_ONLN);
+        if (nthreads < 1) {
+            nthreads = 1;
+        }
+    }
+    memset (&tiled, 0, sizeof (tiled));
+    stra = ed_fetch_string (cmpinfo, 0, &lena);
+    strb = ed_fetch_string (cmpinfo, 1, &lenb);
+    if ((NULL == stra) || (NULL == strb)) {
+        goto end_tiled;
+    }
+    tiled.stra = stra;
+    tiled.strb = strb;
+    tiled.lena = lena;
+    tiled.lenb = lenb;
+    tiled.ntilerow = (lenb + EDTILE_SIZE - 1) / EDTILE_SIZE;
+    tiled.ntilecol = (lena + EDTILE_SIZE - 1) / EDTILE_SIZE;
+    if (nthreads > MAX (MIN (tiled.ntilerow, tiled.ntilecol), 1)) {
+        nthreads = MAX (MIN (tiled.ntilerow, tiled.ntilecol), 1);
+    }
+    /* any tile may be filled by any worker, the shared buffers are interleaved over the nodes of the workers */
+    szhrow = sizeof (int) * (tiled.ntilerow + 1) * (lena + 1);
+    szvcol = sizeof (int) * (tiled.ntilecol + 1) * (lenb + 1);
+    szdir = sizeof (unsigned char) * (lena + 1) * (lenb + 1);
+    tiled.hrow = (int *)ed_numa_alloc (szhrow, nthreads);
+    tiled.vcol = (int *)ed_numa_alloc (szvcol, nthreads);
+    tiled.next = (int *)calloc (tiled.ntilerow + tiled.ntilecol + 1, sizeof (int));
+    tiled.dir = (unsigned char *)ed_numa_alloc (szdir, nthreads);
+    threads = (pthread_t *)malloc (sizeof (pthread_t) * nthreads);
+    if ((NULL == tiled.hrow) || (NULL == tiled.vcol) || (NULL == tiled.next) || (NULL == tiled.dir) || (NULL == threads)) {
+        goto end_tiled;
+    }
+    for (i = 0; i <= lena; i ++) {
+        tiled.hrow[i] = i;
+    }
+    for (k = 0; k <= tiled.ntilerow; k ++) {
+        tiled.hrow[(size_t)k * (lena + 1)] = MIN (k * EDTILE_SIZE, (int)lenb);
+    }
+    for (i = 0; i <= lenb; i ++) {
+        tiled.vcol[i] = i;
+    }
+    for (k = 0; k <= tiled.ntilecol; k ++) {
+        tiled.vcol[(size_t)k * (lenb + 1)] = MIN (k * EDTILE_SIZE, (int)lena);
+    }
+
+    if (tiled.ntilerow > 0 && tiled.ntilecol > 0) {
+        /* 线程创建失败时就用已经创建的线程 */
+        pthread_mutex_init (&(tiled.start), NULL);
+        pthread_mutex_lock (&(tiled.start));
+        for (k = 1; k < nthreads; k ++) {
+            if (0 != pthread_create (&(threads[k]), NULL, ed_tiled_worker, &tiled)) {
+                break;
+            }
+        }
+        nthreads = k;
+        pthread_barrier_init (&(tiled.barrier), NULL, nthreads);
+        pthread_mutex_unlock (&(tiled.start));
+        if (NULL != ed_tiled_worker (&tiled)) {
+            flg_failed = 1;
+        }
+        for (k = 1; k < nthreads; k ++) {
+            if ((0 != pthread_join (threads[k], &res)) || (NULL != res)) {
+                flg_failed = 1;
+            }
+        }
+        ed_numa_unpin ();
+        ed_numa_account ("tiled directions", tiled.dir, szdir);
+        ed_numa_account ("tiled tile borders", tiled.hrow, szhrow);
+        pthread_barrier_destroy (&(tiled.barrier));
+        pthread_mutex_destroy (&(tiled.start));
+        if (flg_failed) {
+            /* the tiles of the failed worker may be taken by the others, but it's out of memory anyway */
+            goto end_tiled;
+        }
+        ret = tiled.hrow[(size_t)tiled.ntilerow * (lena + 1) + lena];
+    } else {
+        ret = MAX (lena, lenb);
+    }
+    *ret_numpath = ed_tiled_traceback (&tiled, path);
+
+end_tiled:
+    if (NULL != threads) {
+        free (threads);
+    }
+    ed_numa_free (tiled.dir, szdir);
+    if (NULL != tiled.next) {
+        free (tiled.next);
+    }
+    ed_numa_free (tiled.vcol, szvcol);
+    ed_numa_free (tiled.hrow, szhrow);
+    if (NULL != stra) {
+        free (stra);
+    }
+    if (NULL != strb) {
+        free (strb);
+    }
+    return ret;
+}
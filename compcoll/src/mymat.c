@@ -7,17 +7,217 @@
  * @date    2016-03-13
  */
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h> /* PATH_MAX */
+#include <unistd.h> /* sysconf() */
+#include <sys/mman.h>
 
 #include "mymat.h"
 
+#if defined(MAP_ANONYMOUS)
+#define USE_MYMAT_MMAP 1
+#else
+#define USE_MYMAT_MMAP 0
+#endif
+
+#define MYMAT_MMAP_MIN  (4UL << 20) /* the buffers of at least this size are mapped by mmap() */
+#define MYMAT_HUGEPAGE  (2UL << 20) /* the size of a huge page, the mapped size is a multiple of it */
+#define MYMAT_READAHEAD 4 /* the bands of MYMAT_TILE rows read ahead in the traceback */
+
+/* free the buffer, by free() or munmap() */
+static void
+mymat_freebuf (mymatrix_t *pm)
+{
+    if (NULL == pm->buf) {
+        return;
+    }
+#if USE_MYMAT_MMAP
+    if (pm->flg_mmap) {
+        munmap (pm->buf, pm->szmem);
+        if (MYMAT_MAP_FILE == pm->flg_mmap) {
+            close (pm->fd);
+        }
+    } else
+#endif
+    {
+        free (pm->buf);
+    }
+    pm->buf = NULL;
+    pm->szmem = 0;
+    pm->flg_mmap = 0;
+}
+
+#if USE_MYMAT_MMAP
+/**
+ * @brief map the memory of at least size bytes
+ *
+ * @param size : the size in bytes
+ * @param flg_hugetlb : try the explicit huge pages first, see mymat_set_hugetlb()
+ * @param ret_size : the size mapped, a multiple of MYMAT_HUGEPAGE
+ * @param ret_type : 1 -- the normal pages, the transparent huge pages are used if the kernel allows; 2 -- the explicit huge pages
+ *
+ * @return the buffer, NULL on error
+ *
+ * The pages of a new mapping are zero-filled by the kernel when they are touched first, so the buffer needs no memset().
+ */
+static void *
+mymat_map (size_t size, char flg_hugetlb, size_t *ret_size, char *ret_type)
+{
+    void *buf;
+
+    size = (size + MYMAT_HUGEPAGE - 1) & ~(MYMAT_HUGEPAGE - 1);
+#if defined(MAP_HUGETLB)
+    if (flg_hugetlb) {
+        buf = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (MAP_FAILED != buf) {
+            *ret_size = size;
+            *ret_type = MYMAT_MAP_HUGETLB;
+            return buf;
+        }
+    }
+#endif
+    buf = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == buf) {
+        return NULL;
+    }
+#if defined(MADV_HUGEPAGE)
+    madvise (buf, size, MADV_HUGEPAGE);
+#endif
+    *ret_size = size;
+    *ret_type = MYMAT_MAP_ANON;
+    return buf;
+}
+
+/**
+ * @brief map the scratch file of at least size bytes
+ *
+ * @param flg_keep : keep the content of the current buffer
+ *
+ * @return 1 if the buffer is zero-filled, 0 if the content is kept, -1 on error
+ *
+ * The file is created in pm->filedir and removed at once, so it goes away with the process.
+ * The pages are written back to the file when the memory is short, so the matrix can be larger than the RAM.
+ * To grow the mapping the file is extended and mapped again, and the content is kept by the file itself.
+ */
+static int
+mymat_map_file (mymatrix_t *pm, size_t size, char flg_keep)
+{
+    char fname[PATH_MAX];
+    void *buf;
+    int fd;
+
+    size = (size + MYMAT_HUGEPAGE - 1) & ~(MYMAT_HUGEPAGE - 1);
+    if (MYMAT_MAP_FILE == pm->flg_mmap) {
+        fd = pm->fd;
+        munmap (pm->buf, pm->szmem);
+        if (! flg_keep) {
+            /* drop the old content, and the blocks on the disk */
+            if (ftruncate (fd, 0) < 0) {
+                goto err_file;
+            }
+        }
+    } else {
+        snprintf (fname, sizeof (fname), "%s/compcoll-XXXXXX", pm->filedir);
+        fd = mkstemp (fname);
+        if (fd < 0) {
+            return -1;
+        }
+        unlink (fname);
+    }
+    if (ftruncate (fd, size) < 0) {
+        goto err_file;
+    }
+    buf = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == buf) {
+        goto err_file;
+    }
+    if (MYMAT_MAP_FILE != pm->flg_mmap) {
+        if (flg_keep && (NULL != pm->buf)) {
+            memcpy (buf, pm->buf, pm->szbuf * pm->szitem);
+        }
+        mymat_freebuf (pm);
+    }
+    pm->buf = buf;
+    pm->szmem = size;
+    pm->flg_mmap = MYMAT_MAP_FILE;
+    pm->fd = fd;
+    return (flg_keep?0:1);
+
+err_file:
+    if (MYMAT_MAP_FILE == pm->flg_mmap) {
+        /* the old mapping is gone */
+        pm->buf = NULL;
+        pm->szmem = 0;
+        pm->flg_mmap = MYMAT_MAP_NONE;
+    }
+    close (fd);
+    return -1;
+}
+
+/* give the pages of [offset, szmem) of the mapped buffer back to the OS, they are zero-filled when touched again */
+static int
+mymat_discard (mymatrix_t *pm, size_t offset)
+{
+    size_t pagesize = ((MYMAT_MAP_HUGETLB == pm->flg_mmap)?MYMAT_HUGEPAGE:(size_t)sysconf (_SC_PAGESIZE));
+    offset = (offset + pagesize - 1) & ~(pagesize - 1);
+    if (offset >= pm->szmem) {
+        return 0;
+    }
+    if (MYMAT_MAP_FILE == pm->flg_mmap) {
+        /* cut the file and extend it again, the blocks on the disk are freed too */
+        if (ftruncate (pm->fd, offset) < 0) {
+            return -1;
+        }
+        return ftruncate (pm->fd, pm->szmem);
+    }
+    return madvise ((char *)(pm->buf) + offset, pm->szmem - offset, MADV_DONTNEED);
+}
+#endif /* USE_MYMAT_MMAP */
+
 int
 mymat_init (void *userdata)
 {
     mymatrix_t *pm = (mymatrix_t *) userdata;
     memset (pm, 0, sizeof (*pm));
+    pm->szitem = sizeof (int);
+    return 0;
+}
+
+/* the element is 1 byte at first, and becomes 2 bytes or sizeof(int) when a value does not fit */
+int
+mymat_init_compact (void *userdata)
+{
+    mymatrix_t *pm = (mymatrix_t *) userdata;
+    mymat_init (pm);
+    pm->szitem = sizeof (int8_t);
+    pm->flg_compact = MYMAT_COMPACT_ELEM;
+    return 0;
+}
+
+/**
+ * @brief initialize the matrix of the values of the DP, stored by the deltas in 2.5 bits per cell
+ *
+ * @param userdata : the mymatrix_t
+ *
+ * @return 0 on success
+ *
+ * The values of two neighbours in a row of the DP differ by at most 1, so the matrix keeps the first value of each
+ * block of 64 cells and the +1 and -1 steps in two bit vectors, see mymat_get_delta(). It's 12.8 times smaller
+ * than the int, 3.2 times smaller than the int8_t, and the value of any cell is still got at once by the popcount.
+ * The fills of edkernel.h, and the checkpoint rows of ed_edit_distance_path_checkpoint(), set the cells of
+ * a row from the left to the right, which the mode needs; mymat_set() fails if a delta is out of [-1, 1].
+ * It's always in the row-major order, mymat_set_tiled() has no effect.
+ */
+int
+mymat_init_delta (void *userdata)
+{
+    mymatrix_t *pm = (mymatrix_t *) userdata;
+    mymat_init (pm);
+    pm->szitem = MYMAT_DELTA_ITEM;
+    pm->flg_compact = MYMAT_COMPACT_DELTA;
     return 0;
 }
 
@@ -25,43 +225,387 @@ int
 mymat_clear (void *userdata)
 {
     mymatrix_t *pm = (mymatrix_t *) userdata;
-    if (NULL != pm->buf) {
-        free (pm->buf);
+    char flg_compact = pm->flg_compact;
+    char flg_tiled = pm->flg_tiled;
+    char flg_nozero = pm->flg_nozero;
+    char flg_hugetlb = pm->flg_hugetlb;
+    const char *filedir = pm->filedir;
+    mymat_freebuf (pm);
+    switch (flg_compact) {
+    case MYMAT_COMPACT_ELEM:
+        mymat_init_compact (pm);
+        break;
+    case MYMAT_COMPACT_DELTA:
+        mymat_init_delta (pm);
+        break;
+    default:
+        mymat_init (pm);
+        break;
     }
-    memset (pm, 0, sizeof (*pm));
+    pm->flg_tiled = flg_tiled;
+    pm->flg_nozero = flg_nozero;
+    pm->flg_hugetlb = flg_hugetlb;
+    pm->filedir = filedir;
     return 0;
 }
 
-/* resize the matrix to (row, col), and clear it */
+/**
+ * @brief select the layout of the elements, used by the next mymat_resize()
+ *
+ * @param userdata : the mymatrix_t
+ * @param flg_tiled : 0 -- row-major(default); 1 -- by the tiles of MYMAT_TILE x MYMAT_TILE
+ *
+ * @return 0 on success, -1 for the delta mode, which is always row-major
+ *
+ * A tile of the tiled layout is 256 elements in a few cache lines, so the neighbours in both the row and the column are
+ * close in memory. It suits the access not in the row-major order, such as ed_edit_distance_path_recursive().
+ */
 int
-mymat_resize (void *userdata, size_t row, size_t col)
+mymat_set_tiled (void *userdata, char flg_tiled)
 {
-    int * newbuf = NULL;
     mymatrix_t *pm = (mymatrix_t *) userdata;
-    size_t newsize = row * col;
+    assert (NULL != pm);
+    if (MYMAT_COMPACT_DELTA == pm->flg_compact) {
+        return (flg_tiled?-1:0);
+    }
+    pm->flg_tiled = flg_tiled;
+    pm->szbuf = 0;
+    pm->szcol = 0;
+    return 0;
+}
 
-    if (NULL == pm->buf) {
-        pm->szbuf = 0;
-        pm->szcol = 0;
+/**
+ * @brief do not clear the elements in mymat_resize()
+ *
+ * @param userdata : the mymatrix_t
+ * @param flg_nozero : 0 -- the elements are 0 after mymat_resize()(default); 1 -- the elements are undefined
+ *
+ * @return 0 on success
+ *
+ * All the fills of editdistance.c and edkernel.h write each element before reading it, so the clearing of
+ * the whole matrix, row x col elements before any work, is not needed.
+ * The large matrix is mapped by mmap() in both modes: a new mapping is zero-filled by the kernel on the first touch,
+ * and a reused one is cleared by madvise(MADV_DONTNEED), so the zeroing does not write the memory either.
+ */
+int
+mymat_set_nozero (void *userdata, char flg_nozero)
+{
+    mymatrix_t *pm = (mymatrix_t *) userdata;
+    assert (NULL != pm);
+    pm->flg_nozero = flg_nozero;
+    return 0;
+}
+
+/**
+ * @brief use the explicit huge pages for the large buffer
+ *
+ * @param userdata : the mymatrix_t
+ * @param flg_hugetlb : 0 -- the normal pages with MADV_HUGEPAGE(default); 1 -- try MAP_HUGETLB first
+ *
+ * @return 0 on success
+ *
+ * The buffers of at least 4 MiB are mapped by mmap(), used by the next mymat_resize(). By default they are the normal
+ * pages, and the kernel backs them by the transparent huge pages if it allows. MAP_HUGETLB takes the pages the
+ * administrator reserved (vm.nr_hugepages), which are shared by the whole system and never swapped, so it's only
+ * used if asked for; it falls back to the normal pages if the reserved ones run out.
+ */
+int
+mymat_set_hugetlb (void *userdata, char flg_hugetlb)
+{
+    mymatrix_t *pm = (mymatrix_t *) userdata;
+    assert (NULL != pm);
+    pm->flg_hugetlb = flg_hugetlb;
+    return 0;
+}
+
+/**
+ * @brief store the large buffer in a scratch file, mapped by mmap()
+ *
+ * @param userdata : the mymatrix_t
+ * @param dir : the directory of the scratch file, kept by the caller; NULL -- in memory(default)
+ *
+ * @return 0 on success, -1 if not supported
+ *
+ * For the matrix larger than the RAM. The buffers of at least 4 MiB are mapped from the file, used by the next mymat_resize().
+ * With mymat_set_tiled() the fill writes the file by the bands of MYMAT_TILE rows from the start to the end,
+ * and the traceback reads it back band by band from the end, see mymat_advise_traceback().
+ */
+int
+mymat_set_file (void *userdata, const char *dir)
+{
+    mymatrix_t *pm = (mymatrix_t *) userdata;
+    assert (NULL != pm);
+#if USE_MYMAT_MMAP
+    pm->filedir = dir;
+    return 0;
+#else
+    return ((NULL == dir)?0:-1);
+#endif
+}
+
+/**
+ * @brief the hint before the traceback, after the fill
+ *
+ * @param userdata : the mymatrix_t
+ *
+ * @return 0 on success, -1 on error
+ *
+ * Only for the scratch file: the MADV_SEQUENTIAL set for the fill by mymat_resize() reads ahead forward
+ * and drops the pages once read, both wrong for the traceback that goes backward. MADV_RANDOM turns them off,
+ * and mymat_advise_traceback() reads the bands above instead.
+ */
+int
+mymat_advise_begin_traceback (void *userdata)
+{
+#if USE_MYMAT_MMAP
+    mymatrix_t *pm = (mymatrix_t *) userdata;
+    assert (NULL != pm);
+    if (MYMAT_MAP_FILE == pm->flg_mmap) {
+        return madvise (pm->buf, pm->szmem, MADV_RANDOM);
     }
-    if (newsize <= pm->szbuf) {
-        memset (pm->buf, 0, sizeof(int) * newsize);
-        pm->szcol = col;
+#endif
+    return 0;
+}
+
+/**
+ * @brief the hint for the traceback that reads the rows from the bottom to the top
+ *
+ * @param userdata : the mymatrix_t
+ * @param row : the row to be read, the first row of its band of MYMAT_TILE rows read by the traceback
+ *
+ * @return 0 on success
+ *
+ * Only for the scratch file: the bands above are read ahead (MADV_WILLNEED) and the bands below, already traced,
+ * are dropped from the memory (MADV_DONTNEED), because the kernel reads ahead only forward.
+ */
+int
+mymat_advise_traceback (void *userdata, size_t row)
+{
+#if USE_MYMAT_MMAP
+    mymatrix_t *pm = (mymatrix_t *) userdata;
+    size_t pagesize = sysconf (_SC_PAGESIZE);
+    size_t szband;
+    size_t band;
+    size_t start;
+    size_t end;
+
+    assert (NULL != pm);
+    if (MYMAT_MAP_FILE != pm->flg_mmap) {
         return 0;
     }
-    if (NULL == pm->buf) {
-        newbuf = (int *)malloc (newsize * sizeof(int));
+    szband = (pm->flg_tiled?pm->sztilerow:(pm->szcol << MYMAT_TILE_BITS)) * pm->szitem;
+    if (MYMAT_COMPACT_DELTA == pm->flg_compact) {
+        /* only the words of the blocks, the first values are small and at the end */
+        szband = (((pm->szcol + MYMAT_DELTA_MASK) >> MYMAT_DELTA_BITS) << MYMAT_TILE_BITS) * 2 * sizeof (uint64_t);
+    }
+    band = row >> MYMAT_TILE_BITS;
+    start = ((band > MYMAT_READAHEAD)?(band - MYMAT_READAHEAD):0) * szband;
+    start &= ~(pagesize - 1);
+    end = (band + 1) * szband;
+    if (end > pm->szmem) {
+        end = pm->szmem;
+    }
+    if (start < end) {
+        madvise ((char *)(pm->buf) + start, end - start, MADV_WILLNEED);
+    }
+    end = (end + pagesize - 1) & ~(pagesize - 1);
+    if (end < pm->szmem) {
+        madvise ((char *)(pm->buf) + end, pm->szmem - end, MADV_DONTNEED);
+    }
+#endif
+    return 0;
+}
+
+/* the size of the element to hold the values in [minval, maxval] */
+static size_t
+mymat_itemsize (int minval, int maxval)
+{
+    if (minval >= INT8_MIN && maxval <= INT8_MAX) {
+        return sizeof (int8_t);
+    }
+    if (minval >= INT16_MIN && maxval <= INT16_MAX) {
+        return sizeof (int16_t);
+    }
+    return sizeof (int);
+}
+
+static int
+mymat_getidx (const mymatrix_t *pm, size_t idx)
+{
+    switch (pm->szitem) {
+    case sizeof (int8_t):
+        return ((int8_t *)(pm->buf))[idx];
+    case sizeof (int16_t):
+        return ((int16_t *)(pm->buf))[idx];
+    }
+    return ((int *)(pm->buf))[idx];
+}
+
+static void
+mymat_setidx (mymatrix_t *pm, size_t idx, int val)
+{
+    switch (pm->szitem) {
+    case sizeof (int8_t):
+        ((int8_t *)(pm->buf))[idx] = val;
+        break;
+    case sizeof (int16_t):
+        ((int16_t *)(pm->buf))[idx] = val;
+        break;
+    default:
+        ((int *)(pm->buf))[idx] = val;
+        break;
+    }
+}
+
+/**
+ * @brief make sure the buffer holds szbuf elements of szitem bytes
+ *
+ * @param flg_keep : keep the current pm->szbuf elements of pm->szitem bytes
+ *
+ * @return 1 if the buffer is new and zero-filled, 0 if the buffer is reused, -1 on error
+ */
+static int
+mymat_reserve (mymatrix_t *pm, size_t szbuf, size_t szitem, char flg_keep)
+{
+    void * newbuf = NULL;
+    size_t size = szbuf * szitem;
+#if USE_MYMAT_MMAP
+    size_t szmap = 0;
+    char type = 0;
+#endif
+
+    if (size <= pm->szmem) {
+        return 0;
+    }
+#if USE_MYMAT_MMAP
+    if ((size >= MYMAT_MMAP_MIN) && (NULL != pm->filedir)) {
+        return mymat_map_file (pm, size, flg_keep);
+    }
+    if (size >= MYMAT_MMAP_MIN) {
+        newbuf = mymat_map (size, pm->flg_hugetlb, &szmap, &type);
+        if (NULL == newbuf) {
+            return -1;
+        }
+        if (flg_keep && (NULL != pm->buf)) {
+            memcpy (newbuf, pm->buf, pm->szbuf * pm->szitem);
+        }
+        mymat_freebuf (pm);
+        pm->buf = newbuf;
+        pm->szmem = szmap;
+        pm->flg_mmap = type;
+        return (flg_keep?0:1);
+    }
+#endif
+    if (flg_keep) {
+        newbuf = realloc (pm->buf, size);
     } else {
-        assert (newsize > pm->szbuf);
-        newbuf = (int *)realloc (pm->buf, sizeof(int) * newsize);
+        /* no copy of the old content */
+        mymat_freebuf (pm);
+        newbuf = malloc (size);
     }
     if (NULL == newbuf) {
         return -1;
     }
     pm->buf = newbuf;
+    pm->szmem = size;
+    return 0;
+}
+
+/* widen the elements of the compact matrix to szitem bytes, keep the values */
+static int
+mymat_promote (mymatrix_t *pm, size_t szitem)
+{
+    mymatrix_t old;
+    size_t i;
+
+    assert (szitem > pm->szitem);
+    if (mymat_reserve (pm, pm->szbuf, szitem, 1) < 0) {
+        return -1;
+    }
+    old = *pm;
+    pm->szitem = szitem;
+    /* from the end, so the new elements never overwrite the old ones not yet moved */
+    for (i = pm->szbuf; i > 0; i --) {
+        mymat_setidx (pm, i - 1, mymat_getidx (&old, i - 1));
+    }
+    return 0;
+}
+
+/**
+ * @brief make the compact matrix hold the values in [minval, maxval] without promotion
+ *
+ * @param userdata : the mymatrix_t
+ * @param minval : the min value to be stored
+ * @param maxval : the max value to be stored
+ *
+ * @return the size of the element in bytes, the caller may access the buffer directly by it
+ *
+ * The content is cleared as by mymat_resize(). The element of a matrix initialized by mymat_init() is always int.
+ * The delta mode returns MYMAT_DELTA_ITEM, the cells are accessed by mymat_get_delta() and mymat_set_delta().
+ */
+size_t
+mymat_fit (void *userdata, int minval, int maxval)
+{
+    mymatrix_t *pm = (mymatrix_t *) userdata;
+    assert (NULL != pm);
+    if (0 == pm->szitem) {
+        pm->szitem = sizeof (int);
+    }
+    if (MYMAT_COMPACT_ELEM == pm->flg_compact) {
+        pm->szitem = mymat_itemsize (minval, maxval);
+        pm->szbuf = 0;
+        pm->szcol = 0;
+    }
+    return pm->szitem;
+}
+
+/* resize the matrix to (row, col), and clear it unless mymat_set_nozero() */
+int
+mymat_resize (void *userdata, size_t row, size_t col)
+{
+    mymatrix_t *pm = (mymatrix_t *) userdata;
+    size_t newsize = row * col;
+    int ret;
+
+    if (pm->flg_tiled) {
+        /* the last row and column of tiles are full */
+        pm->sztilerow = ((col + MYMAT_TILE_MASK) >> MYMAT_TILE_BITS) << (2 * MYMAT_TILE_BITS);
+        newsize = ((row + MYMAT_TILE_MASK) >> MYMAT_TILE_BITS) * pm->sztilerow;
+    } else if (MYMAT_COMPACT_DELTA == pm->flg_compact) {
+        /* the blocks */
+        newsize = row * ((col + MYMAT_DELTA_MASK) >> MYMAT_DELTA_BITS);
+    }
+    if (0 == pm->szitem) {
+        /* not initialized by mymat_init() */
+        pm->szitem = sizeof (int);
+    }
+    ret = mymat_reserve (pm, newsize, pm->szitem, 0);
+    if (ret < 0) {
+        return -1;
+    }
     pm->szbuf = newsize;
     pm->szcol = col;
-    memset (pm->buf, 0, sizeof(int) * newsize);
+#if USE_MYMAT_MMAP
+    if (MYMAT_MAP_FILE == pm->flg_mmap) {
+        /* the fill writes the rows from the top to the bottom */
+        madvise (pm->buf, pm->szmem, MADV_SEQUENTIAL);
+    }
+    if (pm->flg_mmap) {
+        if ((0 == ret) && (! pm->flg_nozero)) {
+            /* zero-filled by the kernel when touched again */
+            if (0 == mymat_discard (pm, 0)) {
+                return 0;
+            }
+        } else {
+            /* the pages used only by a larger matrix before go back to the OS */
+            mymat_discard (pm, pm->szitem * newsize);
+            return 0;
+        }
+    }
+#endif
+    if (! pm->flg_nozero) {
+        memset (pm->buf, 0, pm->szitem * newsize);
+    }
     return 0;
 }
 
@@ -71,25 +615,46 @@ mymat_get (void *userdata, size_t row, size_t col)
 {
     mymatrix_t *pm = (mymatrix_t *) userdata;
     assert (NULL != pm);
-    assert (row * pm->szcol + col < pm->szbuf);
+    assert (col < pm->szcol);
     assert (NULL != pm->buf);
-    return pm->buf[row * pm->szcol + col];
+    if (MYMAT_COMPACT_DELTA == pm->flg_compact) {
+        assert (mymat_index_delta (pm, row, col) < pm->szbuf);
+        return mymat_get_delta (pm, row, col);
+    }
+    assert (mymat_index (pm, row, col) < pm->szbuf);
+    return mymat_getidx (pm, mymat_index (pm, row, col));
 }
 
 /* set the value at (row, col) */
 int
 mymat_set (void *userdata, size_t row, size_t col, int val)
 {
+    size_t szitem;
     mymatrix_t *pm = (mymatrix_t *) userdata;
     assert (NULL != pm);
+    if (MYMAT_COMPACT_DELTA == pm->flg_compact) {
+        assert (col < pm->szcol);
+        assert (mymat_index_delta (pm, row, col) < pm->szbuf);
+        assert (NULL != pm->buf);
+        return mymat_set_delta (pm, row, col, val);
+    }
 #if 1 // DEBUG
-	if (row * pm->szcol + col >= pm->szbuf) {
+	if ((col >= pm->szcol) || (mymat_index (pm, row, col) >= pm->szbuf)) {
 		fprintf (stderr, "Error: row=%d,col=%d,szcol=%d,szbuf=%d\n", (int)row,(int)col,(int)pm->szcol,(int)pm->szbuf);
 	}
 #endif
-    assert (row * pm->szcol + col < pm->szbuf);
+    assert (col < pm->szcol);
+    assert (mymat_index (pm, row, col) < pm->szbuf);
     assert (NULL != pm->buf);
-    pm->buf[row * pm->szcol + col] = val;
+    if (MYMAT_COMPACT_ELEM == pm->flg_compact) {
+        szitem = mymat_itemsize (val, val);
+        if (szitem > pm->szitem) {
+            if (mymat_promote (pm, szitem) < 0) {
+                return -1;
+            }
+        }
+    }
+    mymat_setidx (pm, mymat_index (pm, row, col), val);
     return 0;
 }
 
@@ -10,24 +10,124 @@
 #ifndef __MY_EDCSTR_H
 #define __MY_EDCSTR_H
 
+#include <stdint.h>    /* uint64_t */
 #include <stdlib.h>    /* size_t */
 
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
 
+#define MYMAT_TILE_BITS 4
+#define MYMAT_TILE (1 << MYMAT_TILE_BITS) /* the rows and columns of a tile in the tiled layout */
+#define MYMAT_TILE_MASK (MYMAT_TILE - 1)
+
+/* the value of flg_compact */
+#define MYMAT_COMPACT_NONE  0 /* the element is always int */
+#define MYMAT_COMPACT_ELEM  1 /* the smallest element that holds the values, see mymat_init_compact() */
+#define MYMAT_COMPACT_DELTA 2 /* the deltas of the neighbours in a row, see mymat_init_delta() */
+
+#define MYMAT_DELTA_BITS 6
+#define MYMAT_DELTA_CELLS (1 << MYMAT_DELTA_BITS) /* the cells of a block of a row in the delta mode */
+#define MYMAT_DELTA_MASK (MYMAT_DELTA_CELLS - 1)
+#define MYMAT_DELTA_ITEM (2 * sizeof (uint64_t) + sizeof (int32_t)) /* the bytes of a block: the bits of +1 and -1, and the first value */
+
+/* the value of flg_mmap */
+#define MYMAT_MAP_NONE    0 /* by malloc() */
+#define MYMAT_MAP_ANON    1 /* by mmap(), the transparent huge pages are used if the kernel allows */
+#define MYMAT_MAP_HUGETLB 2 /* by mmap(), the explicit huge pages, see mymat_set_hugetlb() */
+#define MYMAT_MAP_FILE    3 /* by mmap() of the scratch file, see mymat_set_file() */
+
 typedef struct _mymatrix_t {
-    int *buf;
+    void *buf;
     size_t szbuf; // the # of elements in the matrix
     size_t szcol; // number of columns
+    size_t szmem; // the size of the buffer in bytes
+    size_t szitem; // the size of each element, 1, 2 or sizeof(int); MYMAT_DELTA_ITEM for a block of the delta mode
+    char flg_compact; // MYMAT_COMPACT_*
+    char flg_tiled; // store the elements by MYMAT_TILE x MYMAT_TILE tiles, the tiles are in row-major order
+    size_t sztilerow; // the # of elements in a row of tiles, for the tiled layout
+    char flg_nozero; // mymat_resize() does not clear the elements, the caller writes each element before reading it
+    char flg_mmap; // how the buffer of szmem bytes is allocated, MYMAT_MAP_*
+    char flg_hugetlb; // try the explicit huge pages (MAP_HUGETLB) first for the large buffer
+    const char *filedir; // the directory of the scratch file for the large buffer, NULL -- in memory
+    int fd; // the scratch file, if flg_mmap is MYMAT_MAP_FILE
 } mymatrix_t;
 
+/* the index of the element (row, col) in the buffer of the tiled layout */
+static inline size_t
+mymat_index_tiled (const mymatrix_t *pm, size_t row, size_t col)
+{
+    return (row >> MYMAT_TILE_BITS) * pm->sztilerow + ((col >> MYMAT_TILE_BITS) << (2 * MYMAT_TILE_BITS))
+        + ((row & MYMAT_TILE_MASK) << MYMAT_TILE_BITS) + (col & MYMAT_TILE_MASK);
+}
+
+/* the index of the element (row, col) in the buffer */
+static inline size_t
+mymat_index (const mymatrix_t *pm, size_t row, size_t col)
+{
+    if (pm->flg_tiled) {
+        return mymat_index_tiled (pm, row, col);
+    }
+    return row * pm->szcol + col;
+}
+
+/**
+ * In the delta mode each row is stored by the blocks of MYMAT_DELTA_CELLS cells, szbuf is the number of the blocks.
+ * A block keeps its first value, and a bit in each of two words for the cells 1 to 63 that are 1 more or 1 less
+ * than the cell on the left. The buffer holds the words of all the blocks, then the first values.
+ */
+static inline size_t
+mymat_index_delta (const mymatrix_t *pm, size_t row, size_t col)
+{
+    return row * ((pm->szcol + MYMAT_DELTA_MASK) >> MYMAT_DELTA_BITS) + (col >> MYMAT_DELTA_BITS);
+}
+
+static inline int
+mymat_get_delta (const mymatrix_t *pm, size_t row, size_t col)
+{
+    size_t blk = mymat_index_delta (pm, row, col);
+    const uint64_t *w = (const uint64_t *)(pm->buf) + 2 * blk;
+    /* the bits 0 to (col % 64), the bit 0 is never set */
+    uint64_t mask = (~(uint64_t)0) >> (MYMAT_DELTA_MASK - (col & MYMAT_DELTA_MASK));
+    return ((const int32_t *)((const uint64_t *)(pm->buf) + 2 * pm->szbuf))[blk]
+        + __builtin_popcountll (w[0] & mask) - __builtin_popcountll (w[1] & mask);
+}
+
+/* the cell on the left is set before, unless col is the first one of a block; -1 if the delta to it is not in [-1, 1] */
+static inline int
+mymat_set_delta (mymatrix_t *pm, size_t row, size_t col, int val)
+{
+    size_t blk = mymat_index_delta (pm, row, col);
+    uint64_t *w = (uint64_t *)(pm->buf) + 2 * blk;
+    uint64_t bit = (uint64_t)1 << (col & MYMAT_DELTA_MASK);
+    int delta;
+
+    if (0 == (col & MYMAT_DELTA_MASK)) {
+        ((int32_t *)((uint64_t *)(pm->buf) + 2 * pm->szbuf))[blk] = val;
+        w[0] = 0;
+        w[1] = 0;
+        return 0;
+    }
+    delta = val - mymat_get_delta (pm, row, col - 1);
+    w[0] = (w[0] & ~bit) | ((1 == delta)?bit:0);
+    w[1] = (w[1] & ~bit) | ((-1 == delta)?bit:0);
+    return (((delta < -1) || (delta > 1))?-1:0);
+}
+
 int mymat_init (void *userdata);
+int mymat_init_compact (void *userdata);
+int mymat_init_delta (void *userdata);
 int mymat_clear (void *userdata);
+int mymat_set_tiled (void *userdata, char flg_tiled);
+int mymat_set_nozero (void *userdata, char flg_nozero);
+int mymat_set_file (void *userdata, const char *dir);
+int mymat_set_hugetlb (void *userdata, char flg_hugetlb);
+int mymat_advise_begin_traceback (void *userdata);
+int mymat_advise_traceback (void *userdata, size_t row);
 int mymat_resize (void *userdata, size_t row, size_t col);
 int mymat_get (void *userdata, size_t row, size_t col);
 int mymat_set (void *userdata, size_t row, size_t col, int val);
-
+size_t mymat_fit (void *userdata, int minval, int maxval);
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/